@@ -0,0 +1,146 @@
+/*
+ * @url: https://kernel.dk/io_uring.pdf
+ * @lang: c89
+ * @taglist: concurrency, io
+ * @platform: posix
+ * @dependencylist: xxxx_tasks, xxxx_array
+ *
+ * Asynchronous file reads and writes as nodes of the task graph.
+ */
+
+/*
+ * The aio interface
+ * -----------------
+ *
+ * An I/O task is created like any other task, and can be given to task_depends
+ * and task_start. Starting it submits the I/O without blocking a worker; it
+ * completes when the I/O does, which starts its dependencies. Loading many
+ * files thus overlaps with the tasks that decode them.
+ *
+ * @code{@lang{c}
+ * struct aio_request *header = &requests[i];
+ * task_t read, parse;
+ *
+ * header->fd = fd;
+ * header->buffer = header_bytes;
+ * header->size = sizeof header_bytes;
+ * header->offset = 0;
+ *
+ * read = aio_read(header);
+ * parse = task_create(parse_header, header);
+ * task_depends(read, parse);
+ * task_start(read);
+ * }
+ */
+
+#ifndef XXXX_AIO_H
+#define XXXX_AIO_H
+
+#include "xxxx_array.h"
+#include "xxxx_tasks.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* An I/O operation. It must stay valid until the I/O task has completed. */
+struct aio_request {
+    int fd;
+    void *buffer;
+    size_t size;
+    uint64_t offset;
+    /* Written on completion: the number of bytes transferred, which may be
+     * less than size at the end of a file, or -1 on error. */
+    int64_t result;
+    /* Written on completion: 0, or the errno value of the error. */
+    int error;
+};
+
+enum aio_backend {
+    AIO_BACKEND_NONE,
+    AIO_BACKEND_IO_URING,
+    AIO_BACKEND_THREADS
+};
+
+/* Start the aio system with room for queue_depth I/Os in flight, and returns
+ * the backend in use: io_uring when the kernel supports it, a pool of blocking
+ * I/O threads otherwise. Returns AIO_BACKEND_NONE if neither could be started.
+ * Must be called once, after the task system is started. */
+enum aio_backend aio_init(int queue_depth);
+
+/* Wait for all I/Os in flight, then stop the aio system. */
+void aio_shutdown(void);
+
+/* Create an I/O task reading request->size bytes at request->offset of
+ * request->fd into request->buffer, and returns its handle. A null handle
+ * denotes an allocation error. */
+task_t aio_read(struct aio_request *request);
+
+/* Create an I/O task writing request->size bytes from request->buffer at
+ * request->offset of request->fd, and returns its handle. A null handle
+ * denotes an allocation error. */
+task_t aio_write(struct aio_request *request);
+
+/* Create an I/O task which opens the file at path, appends all its bytes to
+ * contents, and closes it, and returns its handle. A null handle denotes an
+ * allocation error.
+ *
+ * On completion, *error is 0, or the errno value of the error, in which case
+ * contents is switched to have failed. Neither path, contents nor error may be
+ * used until the task has completed. */
+task_t aio_read_file(char const *path, Array *contents, int *error);
+
+/*
+ * Implementation notes:
+ *
+ * io_uring backend: one ring, shared by the workers, with submissions batched
+ * under a lock: starting an I/O task fills a submission queue entry whose
+ * user_data is the task's slot, and the entries are submitted with a single
+ * io_uring_enter when the submitting worker goes back to its queue. Completions
+ * are reaped by workers as part of looking for work (before spinning or
+ * parking). Reaping a completion writes the result and completes the I/O task,
+ * which starts its dependencies through the normal path; that path bumps the
+ * idling epoch and calls futex_wake when workers are parked
+ * (@see{task_idle_policy}).
+ *
+ * A futex_wait cannot be woken by a completion, so the last worker about to
+ * park while I/O is in flight does not wait on the epoch: it becomes the
+ * reaper, and blocks in io_uring_enter with IORING_ENTER_GETEVENTS instead.
+ * Completions then wake it directly, and the tasks they start wake the other
+ * workers through the epoch. The role is a flag taken with a compare and swap,
+ * and cleared when io_uring_enter returns; the next worker to run out of work
+ * while I/O is in flight takes it.
+ *
+ * The reaper must also wake for the events which would wake a parked worker:
+ * - it is the timekeeper as well (@see{task_start_at}), and passes the time
+ * left until the earliest deadline as the timeout of io_uring_enter
+ * (IORING_ENTER_EXT_ARG);
+ * - when the reaper flag is set and futex_wake woke nobody, task_start, and
+ * task_start_at when it lowers the earliest deadline, submit an
+ * IORING_OP_NOP whose user_data is the null slot. Its completion returns the
+ * reaper from io_uring_enter, and it polls the queues and recomputes its
+ * timeout before waiting again. This covers a single worker, or serial
+ * scheduling, with tasks started from another thread.
+ *
+ * aio_read_file takes two steps, because linked submissions are all prepared
+ * up front, when the size to read and the descriptor are not yet known:
+ * - openat into a slot of the ring's registered file table (file_index,
+ * allocated by the kernel with IORING_FILE_INDEX_ALLOC, which the openat
+ * completion returns and the task records), linked with a statx of the same
+ * path;
+ * - on the statx completion, the reaping worker grows contents with
+ * array_allocate to the size, and submits a read of the fixed file
+ * (IOSQE_FIXED_FILE with the slot as its descriptor) into the new bytes. A
+ * read that fills them, as happens for files which grew, submits another
+ * one after growing contents again; a short read truncates contents to the
+ * bytes read, and is followed by a close of the slot, which completes the
+ * task. An error at any step closes the slot and completes the task.
+ *
+ * Threads backend: a small pool of threads, outside of the workers, performing
+ * blocking pread/pwrite and completing the I/O tasks the same way.
+ *
+ * The benchmark loads 10k files of 4KB to 1MB, cold and from the page cache,
+ * with a decode task per file, comparing blocking reads inside tasks to both
+ * backends.
+ */
+
+#endif
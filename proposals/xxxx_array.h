@@ -5,7 +5,8 @@
  *
  * A linear and growable region of memory.
  *
- * NOTE(uucidl): this interface does not support custom allocators.
+ * NOTE(uucidl): this interface does not support custom allocators, beyond the
+ * arenas of @see{array_use_arena}.
  */
 
 /*
@@ -38,9 +39,34 @@
  * allocation and inspection functions.
  */
 
+#ifndef XXXX_ARRAY_H
+#define XXXX_ARRAY_H
+
+#include <stddef.h>
 #include <stdint.h>
 
-struct ArrayHeader;
+#ifdef __cplusplus
+#define ARRAY_EXTERN_BEGIN extern "C" {
+#define ARRAY_EXTERN_END }
+#else
+#define ARRAY_EXTERN_BEGIN
+#define ARRAY_EXTERN_END
+#endif
+
+ARRAY_EXTERN_BEGIN
+
+/* The array variable. Its fields are private; they are only exposed so that
+ * arrays can be declared, initialized to all-0 and moved by value.
+ *
+ * - unallocated: region is 0 and allocated is 0.
+ * - failed: region is 0 and allocated is -1.
+ * - allocated: region is nonzero, allocated is positive. */
+struct ArrayHeader {
+    char *region;
+    int64_t allocated;
+    int64_t initialized;
+    struct ArrayArena *arena; /* 0 for the heap */
+};
 typedef struct ArrayHeader Array;
 
 /*
@@ -120,14 +146,50 @@ int64_t array_bytes(Array *x);
  * array_truncate has no effect. If x is unallocated, array_truncate has no
  * effect. If x has failed, array_truncate has no effect.
  *
- * array_truncate does not change the allocation in x. If you want to free the
- * memory used by x, use array_reset.
+ * array_truncate does not change the allocation in x, unless automatic
+ * shrinking is enabled with array_auto_shrink. If you want to free the memory
+ * used by x, use array_shrink or array_reset.
  */
 void array_truncate(Array *x, size_t element_size, size_t len);
 
 /* array_trunc is the same as array_truncate with len equal to 0. */
 void array_trunc(Array *x);
 
+/*
+ * array_shrink reduces the number of bytes allocated in x to the number of
+ * bytes initialized, moving the dynamically allocated region if necessary, and
+ * keeping the initialized bytes. If x has no initialized bytes, array_shrink
+ * is the same as array_reset.
+ *
+ * If x is unallocated, or has failed, array_shrink has no effect. If the
+ * region cannot be moved, array_shrink has no effect either: it never switches
+ * x to have failed.
+ *
+ * Pointers into x must not be used after array_shrink.
+ */
+void array_shrink(Array *x);
+
+/*
+ * array_auto_shrink sets a policy for all arrays: from now on, when
+ * array_truncate or array_trunc leaves fewer than a quarter of the allocated
+ * bytes of x initialized, and x has more than threshold_bytes bytes allocated,
+ * they also call array_shrink on x.
+ *
+ * A threshold_bytes of 0, the default, disables automatic shrinking. Automatic
+ * shrinking trades repeated reallocations for a lower peak, so the threshold
+ * should be well above the size of arrays which are refilled every frame.
+ *
+ * @code{@lang{c}
+ * array_auto_shrink(64 * 1024 * 1024);
+ *
+ * load_level(&level_vertices);
+ * array_shrink(&level_vertices);
+ * ...
+ * array_trunc(&frame_vertices);
+ * }
+ */
+void array_auto_shrink(int64_t threshold_bytes);
+
 /*
  * If x is allocated, array_reset frees the region that x points to, and
  * switches x to being unallocated.
@@ -148,6 +210,28 @@ void array_reset(Array *x);
  */
 void array_fail(Array *x);
 
+/*
+ * Implementation notes for shrinking:
+ *
+ * Regions below a page or so come from malloc, and array_shrink is a realloc
+ * down to the initialized size.
+ *
+ * Large regions (above 1MB) are mappings: when a region crosses 1MB,
+ * array_allocate reserves address space for its growth with mmap(PROT_NONE),
+ * 64 times its size but at least 1GB, and commits it as it grows, so that it
+ * does not move while it fits in the reservation. Growing past the reservation
+ * reserves a new one, 64 times the new size, and moves the region there
+ * (with mremap where available, otherwise by copying), like realloc would. If
+ * no address space is left for it, array_allocate fails as for any other lack
+ * of memory.
+ *
+ * For mappings, array_shrink keeps the reservation and returns the pages past
+ * the initialized bytes with madvise(MADV_FREE), or MADV_DONTNEED where
+ * MADV_FREE is not available. The allocation then counts as the initialized
+ * size rounded up to a page, and growing again reuses the range without
+ * moving.
+ */
+
 /*
  * Comparison
  * ----------
@@ -202,3 +286,166 @@ void array_cat0(Array *x);
  * in y. It fails if pos is negative, or if stop is smaller than pos, or if the
  * number of initialized bytes in y is smaller than stop. */
 void array_cate(Array *x, Array *y, int64_t pos, int64_t stop);
+
+/* array_cat_many appends ys[0], ys[1], ..., ys[n-1] to x, in that order. It
+ * has the same effect as calling array_cat for each of them, but allocates at
+ * most once, for the total number of bytes.
+ *
+ * - If x has failed, array_cat_many has no effect.
+ * - If any of the ys has failed, array_cat_many switches x to have failed.
+ * - If not enough memory is available, array_cat_many switches x to have
+ * failed.
+ *
+ * For copying in parallel, @see{xxxx_array_tasks}. */
+void array_cat_many(Array *x, Array *ys, size_t n);
+
+/*
+ * Arenas
+ * ------
+ *
+ * By default arrays allocate from the heap. An array can instead allocate
+ * from an arena, such as the scratch arena of a task
+ * (@see{xxxx_tasks_scratch}), which all the array functions then use for its
+ * region.
+ */
+
+struct ArrayArena {
+    /* Returns a region of new_bytes bytes starting with the first old_bytes
+     * bytes of region, which is 0 when old_bytes is 0, and releases region.
+     * With new_bytes equal to 0, only releases region and returns 0. Returns 0
+     * without touching region if not enough memory is available. */
+    void *(*reallocate)(struct ArrayArena *arena,
+                        void *region,
+                        size_t old_bytes,
+                        size_t new_bytes);
+};
+
+/* array_use_arena makes x allocate from arena, or from the heap if arena is 0.
+ * x must be unallocated, otherwise array_use_arena has no effect. x keeps using
+ * arena after array_reset and array_fail. An array must not be used after its
+ * arena has been released.
+ *
+ * The arena is part of the array variable: moving an array by value moves its
+ * arena along, and setting a variable back to all-0 makes it allocate from the
+ * heap again. */
+void array_use_arena(Array *x, struct ArrayArena *arena);
+
+/*
+ * Instrumentation
+ * ---------------
+ *
+ * When ARRAY_STATS is defined, the array library keeps statistics about its
+ * memory use, globally, per array, and per call site. Call sites are captured
+ * by the macros below, which record __FILE__ and __LINE__ before calling the
+ * array functions which may allocate. Like any function-like macro, they are
+ * bypassed by parenthesizing the function name, e.g. (array_allocate)(...).
+ *
+ * ARRAY_STATS must be defined for the array implementation and for the code
+ * whose call sites should be recorded. Allocations from code compiled without
+ * it are still counted, under a site with a null file.
+ *
+ * When ARRAY_STATS is not defined, the macros call the functions directly, the
+ * statistics functions compile to nothing, and arrays carry no extra state.
+ *
+ * @code{@lang{c}
+ * Array before = {0,}, after = {0,}, delta = {0,}, text = {0,};
+ *
+ * array_stats_snapshot(&before);
+ * run_frame();
+ * array_stats_snapshot(&after);
+ * array_stats_diff(&delta, &before, &after);
+ * array_stats_dump(&text, &delta);
+ * }
+ */
+
+/* Statistics about a set of allocations. The slack is the number of bytes
+ * allocated but not initialized, i.e. allocated_bytes - initialized_bytes. */
+struct ArrayStats {
+    int64_t allocated_bytes;
+    int64_t peak_allocated_bytes;
+    int64_t initialized_bytes;
+    int64_t allocations;
+    int64_t reallocations;
+    int64_t frees;
+};
+
+/* Statistics of the allocations made from a call site. */
+struct ArraySiteStats {
+    char const *file;
+    int line;
+    struct ArrayStats stats;
+};
+
+#ifdef ARRAY_STATS
+
+/* array_stats_here records the call site of the next array function called by
+ * this thread. */
+void array_stats_here(char const *file, int line);
+
+#define ARRAY_STATS_HERE_(call) (array_stats_here(__FILE__, __LINE__), call)
+#define array_allocate(x, t, pos) ARRAY_STATS_HERE_(array_allocate(x, t, pos))
+#define array_cat(x, y) ARRAY_STATS_HERE_(array_cat(x, y))
+#define array_catb(x, y, len) ARRAY_STATS_HERE_(array_catb(x, y, len))
+#define array_cats(x, y) ARRAY_STATS_HERE_(array_cats(x, y))
+#define array_cats0(x, y) ARRAY_STATS_HERE_(array_cats0(x, y))
+#define array_cat0(x) ARRAY_STATS_HERE_(array_cat0(x))
+#define array_cate(x, y, pos, stop)                                            \
+    ARRAY_STATS_HERE_(array_cate(x, y, pos, stop))
+#define array_cat_many(x, ys, n) ARRAY_STATS_HERE_(array_cat_many(x, ys, n))
+#define array_shrink(x) ARRAY_STATS_HERE_(array_shrink(x))
+
+/* array_stats_total stores the statistics of all arrays in total. */
+void array_stats_total(struct ArrayStats *total);
+
+/* array_stats_array stores the statistics of x in stats. The peak and counters
+ * cover the lifetime of x since it was last unallocated. */
+void array_stats_array(Array *x, struct ArrayStats *stats);
+
+/* array_stats_snapshot appends one struct ArraySiteStats per call site to
+ * snapshot, ordered by file then line. It only copies the site table and does
+ * not walk the arrays. It handles failure in the same way as array_cat. */
+void array_stats_snapshot(Array *snapshot);
+
+/* array_stats_diff appends to delta the difference between the snapshots
+ * before and after, site by site: each field is the value in after minus the
+ * value in before, and sites where nothing changed are omitted. It handles
+ * failure in the same way as array_cat. */
+void array_stats_diff(Array *delta, Array *before, Array *after);
+
+/* array_stats_dump appends to text one line per site of snapshot, in the form
+ * "file:line allocated peak slack allocations reallocations frees", so that
+ * dumps of different frames can be compared with a text diff. It handles
+ * failure in the same way as array_cat. */
+void array_stats_dump(Array *text, Array *snapshot);
+
+#else
+
+#define array_stats_here(file, line) ((void)0)
+#define array_stats_total(total) ((void)0)
+#define array_stats_array(x, stats) ((void)0)
+#define array_stats_snapshot(snapshot) ((void)0)
+#define array_stats_diff(delta, before, after) ((void)0)
+#define array_stats_dump(text, snapshot) ((void)0)
+
+#endif
+
+/*
+ * Implementation notes for the instrumentation:
+ *
+ * The call site is kept in a thread local variable, consumed (reset to the
+ * null site) by the next array function. The implementation file defines the
+ * functions with parenthesized names, which the call site macros skip.
+ *
+ * Sites are interned in a hash table keyed by the (file, line) pair; file
+ * pointers are compared by address first, which succeeds for all calls from the
+ * same translation unit. The counters are updated with relaxed atomic adds.
+ *
+ * In ARRAY_STATS builds the region of each array is preceded by a hidden
+ * prefix recording the site that allocated it and its own counters, so that
+ * array_reset can subtract its bytes from the right site. The ArrayHeader
+ * itself is the same in all builds.
+ */
+
+ARRAY_EXTERN_END
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * @lang: c++11
+ * @taglist: ADT
+ * @dependencylist: xxxx_array
+ *
+ * An owning, typed C++ wrapper around an array, and a span over its elements.
+ * Both are header-only and compile to the same code as the array functions
+ * they call.
+ */
+
+/*
+ * The wrapper interface
+ * ---------------------
+ *
+ * An ArrayOf<T> owns an array variable, and resets it when destroyed, so that
+ * no path (including exceptions) leaks it. It can be moved but not copied:
+ * moving takes the ArrayHeader of the source, which becomes unallocated, and
+ * never copies the elements. Like after array_reset, the source keeps using
+ * its arena (@see{array_use_arena}), and so does the array given to adopt or
+ * returned by release.
+ *
+ * Elements are stored by their bytes, exactly like with the C functions, so T
+ * must be trivially copyable. Like the C functions, the wrapper reports errors
+ * with null pointers and the failed state, and never throws.
+ *
+ * @code{@lang{c++}
+ * ArrayOf<float> depths;
+ *
+ * depths.push_back(1.0f);
+ * depths.push_back(0.5f);
+ * std::sort(depths.begin(), depths.end());
+ *
+ * legacy_c_function(depths.c_array());
+ * }
+ *
+ * With ARRAY_STATS, the wrapper calls the array functions without the call
+ * site macros, so that allocations are not all attributed to this header.
+ * Record the caller's site with array_stats_here before a call which may
+ * allocate; otherwise the allocation counts under the null site.
+ *
+ * @code{@lang{c++}
+ * array_stats_here(__FILE__, __LINE__);
+ * depths.push_back(2.0f);
+ * }
+ */
+
+#ifndef XXXX_ARRAY_CXX_H
+#define XXXX_ARRAY_CXX_H
+
+#include "xxxx_array.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/* A contiguous range of elements, such as the contents of an array. Like the
+ * pointers returned by the array functions, it must not be used after an
+ * operation which may reallocate the array. */
+template <typename T> struct ArraySpanOf {
+    T *first;
+    std::size_t n;
+
+    T *begin() const { return first; }
+    T *end() const { return first + n; }
+    T *data() const { return first; }
+    std::size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    T &operator[](std::size_t i) const { return first[i]; }
+};
+
+template <typename T> class ArrayOf
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "array elements are copied as bytes");
+
+  public:
+    ArrayOf() noexcept : header_() {}
+    ~ArrayOf() { array_reset(&header_); }
+
+    ArrayOf(ArrayOf const &) = delete;
+    ArrayOf &operator=(ArrayOf const &) = delete;
+
+    ArrayOf(ArrayOf &&other) noexcept : header_(other.header_)
+    {
+        other.header_ = emptied(other.header_);
+    }
+
+    ArrayOf &operator=(ArrayOf &&other) noexcept
+    {
+        if (this != &other) {
+            array_reset(&header_);
+            header_ = other.header_;
+            other.header_ = emptied(other.header_);
+        }
+        return *this;
+    }
+
+    /* Takes ownership of x, which becomes unallocated. */
+    static ArrayOf adopt(Array *x) noexcept
+    {
+        ArrayOf result;
+        result.header_ = *x;
+        *x = emptied(*x);
+        return result;
+    }
+
+    /* Gives up ownership: the caller must reset the returned array. This
+     * array becomes unallocated. */
+    Array release() noexcept
+    {
+        Array result = header_;
+        header_ = emptied(header_);
+        return result;
+    }
+
+    /* The underlying array, for use with the C functions. */
+    Array *c_array() noexcept { return &header_; }
+
+    /* @see{array_allocate} */
+    T *allocate(std::int64_t pos) noexcept
+    {
+        return static_cast<T *>((array_allocate)(&header_, sizeof(T), pos));
+    }
+
+    /* @see{array_get} */
+    T *get(std::int64_t pos) noexcept
+    {
+        return static_cast<T *>(array_get(&header_, sizeof(T), pos));
+    }
+
+    T const *get(std::int64_t pos) const noexcept
+    {
+        return static_cast<T const *>(array_get(header(), sizeof(T), pos));
+    }
+
+    /* Appends value, and returns a pointer to the new element, or 0 if
+     * something went wrong (@see{array_allocate}.) */
+    T *push_back(T const &value) noexcept
+    {
+        T *result = allocate(size());
+        if (result) {
+            *result = value;
+        }
+        return result;
+    }
+
+    /* @see{array_truncate} */
+    void truncate(std::size_t len) noexcept
+    {
+        array_truncate(&header_, sizeof(T), len);
+    }
+
+    /* @see{array_reset} */
+    void reset() noexcept { array_reset(&header_); }
+
+    bool failed() const noexcept
+    {
+        return array_length(header(), sizeof(T)) < 0;
+    }
+
+    /* The number of elements, or 0 if the array has failed. */
+    std::int64_t size() const noexcept
+    {
+        std::int64_t n = array_length(header(), sizeof(T));
+        return n < 0 ? 0 : n;
+    }
+
+    T *begin() noexcept { return static_cast<T *>(array_start(&header_)); }
+    T *end() noexcept { return begin() + size(); }
+
+    T const *begin() const noexcept
+    {
+        return static_cast<T const *>(array_start(header()));
+    }
+    T const *end() const noexcept { return begin() + size(); }
+
+    ArraySpanOf<T> span() noexcept
+    {
+        ArraySpanOf<T> result = {begin(), static_cast<std::size_t>(size())};
+        return result;
+    }
+
+    ArraySpanOf<T const> span() const noexcept
+    {
+        ArraySpanOf<T const> result = {begin(),
+                                       static_cast<std::size_t>(size())};
+        return result;
+    }
+
+  private:
+    /* An unallocated array, using the same arena as x. */
+    static Array emptied(Array const &x) noexcept
+    {
+        Array result = Array();
+        array_use_arena(&result, x.arena);
+        return result;
+    }
+
+    /* The array functions take non-const arrays, even to inspect them. */
+    Array *header() const noexcept { return const_cast<Array *>(&header_); }
+
+    Array header_;
+};
+
+/*
+ * Implementation notes:
+ *
+ * The wrapper only adds inline calls, so with optimizations on, a loop over
+ * push_back or begin()/end() should compile to the same instructions as the
+ * equivalent calls to array_allocate and array_start. The benchmark times
+ * appends, sorting and iteration with the wrapper and with the C functions,
+ * and the generated assembly for both is compared on each supported compiler.
+ *
+ * When the array implementation is compiled in the same unit (or with LTO),
+ * array_start and array_length inline to loads of the header fields, which is
+ * what makes end() free in loops.
+ */
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * @url: https://github.com/ulfjack/ryu
+ * @lang: c89
+ * @taglist: ADT, text
+ * @dependencylist: xxxx_array
+ *
+ * Appending the decimal or hexadecimal text of numbers to an array, without
+ * going through a temporary buffer.
+ */
+
+#ifndef XXXX_ARRAY_FMT_H
+#define XXXX_ARRAY_FMT_H
+
+#include "xxxx_array.h"
+
+#include <stdint.h>
+
+/*
+ * Formatting
+ * ----------
+ *
+ * These functions are like array_cats with the text of a number as y. None of
+ * them append a terminating 0 byte; use array_cat0 for that.
+ *
+ * @code{@lang{c}
+ * array_cats(&csv, "frame,");
+ * array_cat_u64(&csv, frame_index);
+ * array_cats(&csv, ",");
+ * array_cat_f64(&csv, frame_seconds);
+ * array_cats(&csv, "\n");
+ * }
+ *
+ * They handle failure in the same way as array_cat.
+ */
+
+/* array_cat_u64 appends the decimal digits of v, without leading zeros. 0 is
+ * written as "0". */
+void array_cat_u64(Array *x, uint64_t v);
+
+/* array_cat_i64 is like array_cat_u64, preceded by "-" when v is negative. */
+void array_cat_i64(Array *x, int64_t v);
+
+/* array_cat_hex appends the lowercase hexadecimal digits of v, without prefix
+ * and without leading zeros. 0 is written as "0". */
+void array_cat_hex(Array *x, uint64_t v);
+
+/*
+ * array_cat_f64 appends the shortest decimal text which reads back as exactly
+ * v, e.g. with strtod. Among texts of that length, it picks the one closest to
+ * v.
+ *
+ * The text uses positional notation ("0.001", "123.5", "100") when the decimal
+ * exponent of v is between -6 and 20, and scientific notation ("1e-7",
+ * "1.5e+21") otherwise. Finite values are therefore valid JSON numbers.
+ *
+ * Negative zero is written as "-0", infinities as "inf" and "-inf", and NaNs as
+ * "nan".
+ */
+void array_cat_f64(Array *x, double v);
+
+/*
+ * Implementation notes:
+ *
+ * None of these functions format into a temporary. They count the output
+ * length first, reserve it at the tail of x with a single array_allocate, and
+ * write the digits straight into place.
+ *
+ * - integers: the number of digits comes from the bit length of v (via clz)
+ * and a table of powers of 10. Digits are written from right to left, two at a
+ * time, from a 200 byte table of the pairs "00" to "99", which halves the
+ * number of divisions.
+ * - hexadecimal: the number of digits is (67 - clz(v|1)) / 4, and each byte of
+ * v is written with a 512 byte table of the pairs "00" to "ff".
+ * - floating point: the shortest digits come from Ryu (see @url) as a 17 digit
+ * integer mantissa and a decimal exponent. The mantissa is then written with
+ * the integer routine, with the decimal point or exponent inserted.
+ *
+ * The benchmark compares each function to snprintf("%llu"), snprintf("%llx")
+ * and snprintf("%.17g") into a stack buffer followed by array_cats, on uniform
+ * random values and on values typical of CSV exports (small integers, values
+ * with few significant digits.)
+ */
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * @lang: c89
+ * @taglist: ADT, io
+ * @platform: posix
+ * @dependencylist: xxxx_array, xxxx_array_search
+ *
+ * A durable, append-only log of records stored in a file.
+ *
+ * Appending a record costs a copy, like array_catb. Making it durable is done
+ * in the background for groups of records at a time, with a bounded delay.
+ */
+
+/*
+ * The array log interface
+ * -----------------------
+ *
+ * A log is a sequence of records, each a sequence of bytes of at most
+ * ARRAY_LOG_MAX_RECORD bytes. Records are identified by their position: the
+ * byte offset of the record from the end of the file header, so that the first
+ * record is at position 0.
+ *
+ * An appended record is immediately visible to readers of the same log. It is
+ * durable, i.e. it survives a crash of the process or of the machine, once the
+ * log has been synchronized past it. This happens on its own at most
+ * sync_interval_microseconds after the append, or sooner once sync_bytes bytes
+ * are waiting, and may be waited for with array_log_sync.
+ *
+ * @code{@lang{c}
+ * struct ArrayLog *events = array_log_open("events.log", 0);
+ * int64_t pos;
+ *
+ * pos = array_log_cat(events, &frame_events);
+ * ...
+ * array_log_sync(events, pos);
+ * }
+ */
+
+#ifndef XXXX_ARRAY_LOG_H
+#define XXXX_ARRAY_LOG_H
+
+#include "xxxx_array.h"
+#include "xxxx_array_search.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct ArrayLog;
+
+/* Longest record, in bytes. */
+enum { ARRAY_LOG_MAX_RECORD = 0x7fffffff };
+
+/* Zero fields take a default value. */
+struct ArrayLogOptions {
+    /* Maximum delay between an append and its record becoming durable.
+     * Default: 10000 (10ms) */
+    uint64_t sync_interval_microseconds;
+    /* Number of appended bytes which triggers a sync before the interval has
+     * elapsed. Default: 1MB */
+    size_t sync_bytes;
+    /* The file is extended in steps of this many bytes. Default: 64MB */
+    size_t extent_bytes;
+    /* Largest size of the log, for which address space is reserved when it
+     * is opened. Default: 64GB */
+    uint64_t max_bytes;
+};
+
+/*
+ * Opening and closing
+ * -------------------
+ */
+
+/* array_log_open opens the log stored in the file at path, creating it if it
+ * does not exist. options may be 0 for the defaults.
+ *
+ * Opening recovers the log: all records are read back and their checksums
+ * verified. The log ends after the last valid record; anything after it, such
+ * as a record torn by a crash, is discarded.
+ *
+ * If something goes wrong, array_log_open returns 0, setting errno
+ * appropriately. */
+struct ArrayLog *array_log_open(char const *path,
+                                struct ArrayLogOptions const *options);
+
+/* array_log_close makes all records durable, then frees the log. It returns 0,
+ * setting errno appropriately, if the final synchronization failed; the log is
+ * freed in every case. */
+int array_log_close(struct ArrayLog *log);
+
+/*
+ * Appending
+ * ---------
+ */
+
+/* array_log_catb appends a record made of the bytes y[0], y[1], ...,
+ * y[len-1], and returns its position.
+ *
+ * If something goes wrong, array_log_catb returns -1, setting errno
+ * appropriately, without appending anything. In particular, it fails with
+ * EFBIG if len is above ARRAY_LOG_MAX_RECORD, and with ENOSPC once the log
+ * would grow past max_bytes. Once a synchronization has failed, every append
+ * fails. */
+int64_t array_log_catb(struct ArrayLog *log, char const *y, size_t len);
+
+/* array_log_cat appends a record made of the initialized bytes of y. It
+ * returns -1 if y has failed, and otherwise behaves like array_log_catb. */
+int64_t array_log_cat(struct ArrayLog *log, Array *y);
+
+/*
+ * Durability
+ * ----------
+ */
+
+/* array_log_durable returns the position past which records are not yet
+ * known to be durable. It does not block. */
+int64_t array_log_durable(struct ArrayLog *log);
+
+/* array_log_sync waits until the record at pos, and all records before it, are
+ * durable, and returns nonzero. It returns 0, setting errno appropriately, if
+ * synchronization failed. */
+int array_log_sync(struct ArrayLog *log, int64_t pos);
+
+/*
+ * Reading
+ * -------
+ */
+
+/* array_log_next reads the record at *pos into record, advances *pos to the
+ * next record, and returns nonzero. Starting with *pos = 0 visits every record
+ * in order. It returns 0 without touching record when *pos is at the end of
+ * the log.
+ *
+ * The record points directly into a read-only mapping of the file, and remains
+ * valid until the log is closed. */
+int array_log_next(struct ArrayLog *log,
+                   int64_t *pos,
+                   struct ArraySlice *record);
+
+/*
+ * Implementation notes:
+ *
+ * File format: a header with a magic number and version, then records, each
+ * made of a 32 bit length (whose top bit is reserved, hence
+ * ARRAY_LOG_MAX_RECORD), a 32 bit CRC32C of the length and the bytes, the
+ * bytes themselves, and padding to 8 bytes. A length of 0 with a checksum of 0
+ * cannot be valid, which is what the unused, zero-filled tail of the file
+ * reads as.
+ *
+ * Appends: the file is extended extent_bytes at a time with fallocate, so that
+ * appends never change the file size. Fallocated extents are unwritten, and
+ * the first write into them converts them, which is a metadata update. To keep
+ * that off the commit path, the background thread zero-fills the next extent,
+ * and fdatasyncs it, before the log reaches it; group commits then only
+ * write data. Records are written with pwrite at the end of the log under a
+ * mutex, which makes the append cost a copy into the page cache.
+ *
+ * Group commit: a background thread calls fdatasync when the oldest
+ * unsynchronized record reaches sync_interval_microseconds, when sync_bytes
+ * are pending, or when array_log_sync is waiting. A single fdatasync covers all
+ * the records appended before it started, and wakes all their waiters.
+ *
+ * Reading: opening reserves max_bytes of address space with
+ * mmap(PROT_NONE), and each extent of the file is mapped read-only at its own
+ * offset inside the reservation with MAP_FIXED as the file is extended. The
+ * mapping therefore never moves, and records crossing an extent boundary are
+ * still contiguous, so slices remain valid until close, which unmaps the
+ * whole range.
+ *
+ * Recovery: the records are scanned from the start, checking the length
+ * against the file size and the checksum. The first invalid record marks the
+ * end of the log. Records after it may have reached the disk without ever
+ * being acknowledged, and one of them could pass its checksum once a new
+ * record of the right size is written over the invalid one. So everything from
+ * the first invalid record to the end of the file is zeroed, with
+ * fallocate(FALLOC_FL_ZERO_RANGE) or by writing zeros, and fdatasynced before
+ * the log is returned.
+ */
+
+#endif
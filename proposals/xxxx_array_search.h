@@ -0,0 +1,116 @@
+/*
+ * @lang: c89
+ * @taglist: ADT, text
+ * @dependencylist: xxxx_array
+ *
+ * Searching inside the initialized bytes of an array: for a single byte, for
+ * any byte of a set, or for a substring. Splitting an array into slices
+ * without copying.
+ */
+
+#ifndef XXXX_ARRAY_SEARCH_H
+#define XXXX_ARRAY_SEARCH_H
+
+#include "xxxx_array.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Search
+ * ------
+ *
+ * All search functions look at byte positions pos through array_bytes(x)-1 and
+ * return the position of the first match, counted from the start of x (not
+ * from pos.)
+ *
+ * They return -1 if there is no match, or if:
+ * - x is unallocated or has failed, or
+ * - pos is negative, or
+ * - pos is larger than the number of initialized bytes in x.
+ *
+ * They never change x.
+ */
+
+/* array_find_byte returns the position of the first byte equal to c. */
+int64_t array_find_byte(Array *x, int64_t pos, char c);
+
+/* array_find_any returns the position of the first byte equal to any of the
+ * bytes set[0], set[1], ..., set[set_n-1]. If set_n is 0, there is no match. */
+int64_t
+array_find_any(Array *x, int64_t pos, char const *set_first, size_t set_n);
+
+/* array_find returns the position of the first occurrence of the bytes
+ * needle[0], needle[1], ..., needle[needle_n-1]. An empty needle matches at
+ * pos. */
+int64_t
+array_find(Array *x, int64_t pos, char const *needle_first, size_t needle_n);
+
+/*
+ * Splitting
+ * ---------
+ *
+ * A slice designates a range of initialized bytes of an array. Like the
+ * pointer returned by array_allocate, a slice can continue to be used through
+ * subsequent calls to array_get, array_start, array_length, array_bytes and the
+ * search functions, but it must not be used after any other operations on this
+ * array.
+ *
+ * @code{@lang{c}
+ * struct ArraySplit lines;
+ * struct ArraySlice line;
+ *
+ * array_split_init(&lines, &x, '\n');
+ * while (array_split_next(&lines, &line)) {
+ *     process_line(line.first, line.n);
+ * }
+ * }
+ */
+
+struct ArraySlice {
+    char const *first;
+    size_t n;
+};
+
+/* Iteration state for array_split_next. Its fields are private. */
+struct ArraySplit {
+    Array *x;
+    int64_t pos;
+    char delimiter;
+};
+
+/* array_split_init prepares split to iterate over the parts of x separated by
+ * the byte delimiter. It does not change x. */
+void array_split_init(struct ArraySplit *split, Array *x, char delimiter);
+
+/* array_split_next stores the next part in slice, not including the delimiter,
+ * and returns nonzero. Once all parts have been produced it returns 0 without
+ * touching slice.
+ *
+ * n delimiters produce n+1 parts, some of which may be empty. An unallocated
+ * array produces a single empty part. An array that has failed produces none.
+ */
+int array_split_next(struct ArraySplit *split, struct ArraySlice *slice);
+
+/*
+ * Implementation notes:
+ *
+ * The scalar loops are the reference. The hot loops are written three times,
+ * scalar, SSE2 and AVX2, and the implementation picks one on first use with
+ * cpuid and stores it in a function pointer. SSE2 is always present on x86-64,
+ * so the scalar loop only ever runs on other targets.
+ *
+ * - array_find_byte: compare 32 bytes at a time against a broadcast of c, then
+ * movemask and count trailing zeros. Unroll to 4 vectors per iteration and OR
+ * the masks so there is only one branch per 128 bytes. Align the loads by
+ * handling the head with a masked compare. This is what makes newline scanning
+ * run at memory bandwidth (the target is 10GB/s over a 1GB buffer.)
+ * - array_find_any: for up to 3 bytes, OR together one compare per byte. For
+ * larger sets, use a nibble lookup table with two pshufb and an AND.
+ * - array_find: search for the first and last byte of the needle at their
+ * respective offsets, AND both masks, and only compare the whole needle at the
+ * remaining candidates.
+ * - array_split_next: is a loop around array_find_byte, and never copies.
+ */
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * @url: http://stereopsis.com/radix.html
+ * @lang: c89
+ * @taglist: ADT, algorithm, concurrency
+ * @dependencylist: xxxx_array, xxxx_tasks
+ *
+ * Radix sorting the fixed-size records of an array by an integer or floating
+ * point key, on one thread or as a graph of tasks.
+ */
+
+#ifndef XXXX_ARRAY_SORT_H
+#define XXXX_ARRAY_SORT_H
+
+#include "xxxx_array.h"
+#include "xxxx_tasks.h"
+
+#include <stddef.h>
+
+/*
+ * Keys
+ * ----
+ *
+ * The key of a record is stored at byte offset key_offset in the record, in
+ * native byte order, and must be suitably aligned for its type.
+ *
+ * Floating point keys are sorted by the IEEE 754 total order: negative NaNs,
+ * -infinity, negative numbers, -0, +0, positive numbers, +infinity, then
+ * positive NaNs.
+ */
+
+enum ArraySortKey {
+    ArraySortKey_U32,
+    ArraySortKey_U64,
+    ArraySortKey_I32,
+    ArraySortKey_I64,
+    ArraySortKey_F32,
+    ArraySortKey_F64
+};
+
+/*
+ * Sorting
+ * -------
+ *
+ * The sort is stable: records with equal keys keep their relative order.
+ *
+ * For records of up to 16 bytes, the sort needs as many bytes of scratch space
+ * as x has initialized bytes. Larger records are sorted through (key, index)
+ * pairs, and need element_size + 16 bytes of scratch space per record. In
+ * both cases, add a few kilobytes for the histograms. The sort obtains them
+ * from scratch with array_allocate, then truncates scratch to 0 bytes. Passing
+ * the same scratch array every frame therefore allocates only once.
+ *
+ * @code{@lang{c}
+ * struct Particle {
+ *     float depth;
+ *     uint32_t index;
+ * };
+ *
+ * array_sort(&particles, sizeof(struct Particle),
+ *            offsetof(struct Particle, depth), ArraySortKey_F32, &scratch);
+ * }
+ */
+
+/* array_sort sorts the records of x, each element_size bytes long, by their
+ * key in increasing order, and returns nonzero.
+ *
+ * If something goes wrong, array_sort returns 0, setting errno appropriately,
+ * without touching x. In particular, array_sort returns 0 if:
+ * - x or scratch has failed, or
+ * - the key does not fit in the record, or
+ * - not enough memory is available for scratch.
+ *
+ * If x is unallocated, array_sort has no effect and returns nonzero. */
+int array_sort(Array *x,
+               size_t element_size,
+               size_t key_offset,
+               enum ArraySortKey key,
+               Array *scratch);
+
+/* array_sort_task creates the tasks for sorting x like array_sort, splitting
+ * the records across up to task_count tasks. It returns the task which starts
+ * the sort; the caller starts it with task_start. Once x is sorted, the task
+ * `then` is started, unless it is the null task.
+ *
+ * Neither x nor scratch may be used until `then` has started.
+ *
+ * All the memory is obtained when the tasks are created: array_sort_task
+ * returns the null task, without touching x, in the same cases where array_sort
+ * returns 0, or if the tasks cannot be created.
+ */
+task_t array_sort_task(Array *x,
+                       size_t element_size,
+                       size_t key_offset,
+                       enum ArraySortKey key,
+                       Array *scratch,
+                       int task_count,
+                       task_t then);
+
+/*
+ * Implementation notes:
+ *
+ * This is a least significant digit first radix sort with 8 bit digits, i.e.
+ * 4 passes for 32 bit keys and 8 for 64 bit keys, ping-ponging between x and
+ * scratch. If an odd number of passes ran, a final copy moves the result back
+ * into x.
+ *
+ * - All the histograms are computed in a single read of x before the first
+ * pass. A pass whose histogram has a single non-empty bucket is skipped, which
+ * is common for the high digits of small integers.
+ * - Signed keys flip their sign bit. Floating point keys flip their sign bit
+ * when positive and all their bits when negative (see @url), which turns the
+ * total order into an unsigned order.
+ * - Records of 4 or 8 bytes move as single words. Larger records would move a
+ * lot of bytes per pass: above 16 bytes, sort (key, index) pairs instead and
+ * permute the records once at the end. The pairs take at most 16 bytes, and
+ * ping-pong between two buffers of 16 bytes per record. The permutation then
+ * gathers the records into scratch in sorted order, reusing the buffer the
+ * pairs are not in, and copies them back into x: the peak is the sorted pairs
+ * plus one copy of the records, i.e. element_size + 16 bytes per record.
+ * - Below a few hundred records, an insertion sort is faster than building
+ * the histograms.
+ *
+ * The parallel sort gives each task a contiguous block of records. Per pass,
+ * every task histograms its block, a serial task computes each task's offset
+ * in every bucket with a prefix sum over (bucket, task), then every task
+ * scatters its block. The histograms live at the end of scratch, one per task,
+ * each padded to a cache line.
+ *
+ * The benchmark sorts uniform random keys, and nearly sorted ones, for every
+ * key type at 1K, 10K, 100K, 1M, 10M and 100M records of 4, 8 and 16 bytes,
+ * against qsort with a key comparison function.
+ */
+
+#endif
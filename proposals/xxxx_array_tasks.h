@@ -0,0 +1,75 @@
+/*
+ * @lang: c89
+ * @taglist: ADT, concurrency
+ * @dependencylist: xxxx_array, xxxx_tasks
+ *
+ * Array operations performed by a graph of tasks, for arrays large enough that
+ * copying them is worth spreading across workers.
+ */
+
+#ifndef XXXX_ARRAY_TASKS_H
+#define XXXX_ARRAY_TASKS_H
+
+#include "xxxx_array.h"
+#include "xxxx_tasks.h"
+
+#include <stddef.h>
+
+/*
+ * Concatenation
+ * -------------
+ */
+
+/* array_cat_many_task creates the tasks for appending ys[0], ys[1], ...,
+ * ys[n-1] to x, like array_cat_many, with the copies split across up to
+ * task_count tasks. It returns the task which starts the copies; the caller
+ * starts it with task_start. Once all bytes are copied, the task `then` is
+ * started, unless it is the null task.
+ *
+ * x is grown, and its initialized bytes set to the final size, before
+ * array_cat_many_task returns. The appended bytes must not be read, and
+ * neither x nor the ys may be changed, until `then` has started.
+ *
+ * array_cat_many_task returns the null task, and switches x to have failed, in
+ * the same cases where array_cat_many would, or if the tasks cannot be
+ * created.
+ *
+ * @code{@lang{c}
+ * task_t copy = array_cat_many_task(&frame, per_thread, thread_count, 16,
+ *                                   submit_frame);
+ * if (copy.id) {
+ *     task_start(copy);
+ * }
+ * }
+ */
+task_t array_cat_many_task(Array *x,
+                           Array *ys,
+                           size_t n,
+                           int task_count,
+                           task_t then);
+
+/*
+ * Implementation notes:
+ *
+ * The destination offset of each source is a prefix sum of their sizes,
+ * computed while checking for failed sources, and x is grown once with
+ * array_allocate to the total size.
+ *
+ * The total is then cut into task_count chunks of equal size, regardless of
+ * source boundaries, so that a few large sources among many small ones still
+ * balance: each task copies the parts of the sources which fall in its chunk.
+ * Chunk boundaries are rounded to multiples of 64KB of the destination
+ * address, not of the offset in x, whose appended bytes start wherever its
+ * existing bytes end: no two tasks then write to the same page, and only the
+ * first and last chunks are partial.
+ *
+ * Below 1MB in total, copying is faster than waking workers: a single task
+ * does all the copies.
+ *
+ * The benchmark appends 256 sources of 4MB each (1GB), with a loop of
+ * array_cat, with array_cat_many, and with array_cat_many_task over 1 to all
+ * workers. Parallel copies are bound by memory bandwidth, and should reach it
+ * with a few workers.
+ */
+
+#endif
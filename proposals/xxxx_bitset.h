@@ -0,0 +1,114 @@
+/*
+ * @lang: c89
+ * @taglist: ADT
+ * @dependencylist: xxxx_array
+ *
+ * Sets of non-negative integers, stored one bit per integer in an array.
+ */
+
+/*
+ * The bitset library interface
+ * ----------------------------
+ *
+ * A bitset is an ordinary array variable, whose initialized bytes are read as
+ * 64 bit words: bit i of the set is bit (i % 64) of word (i / 64). It follows
+ * all the rules of arrays. In particular, it is created unallocated, which
+ * represents the empty set, and it is freed with array_reset.
+ *
+ * Bits past the initialized words are 0. Setting one of them grows the array
+ * with array_allocate, so that flags indexed by entity need no separate
+ * sizing.
+ *
+ * @code{@lang{c}
+ * Array visible = {0,};
+ * int64_t i;
+ *
+ * bitset_set(&visible, entity_index);
+ *
+ * for (i = bitset_next(&visible, 0); i >= 0;
+ *      i = bitset_next(&visible, i + 1)) {
+ *     draw(i);
+ * }
+ * }
+ */
+
+#ifndef XXXX_BITSET_H
+#define XXXX_BITSET_H
+
+#include "xxxx_array.h"
+
+#include <stdint.h>
+
+/*
+ * Single bits
+ * -----------
+ */
+
+/* bitset_set sets bit pos, growing x if necessary. It handles failure in the
+ * same way as array_cat, and has no effect if pos is negative. */
+void bitset_set(Array *x, int64_t pos);
+
+/* bitset_clear clears bit pos. It never grows x. */
+void bitset_clear(Array *x, int64_t pos);
+
+/* bitset_test returns nonzero if bit pos is set. It returns 0 if pos is
+ * negative, if x is unallocated, or if x has failed. */
+int bitset_test(Array *x, int64_t pos);
+
+/*
+ * Bulk operations
+ * ---------------
+ *
+ * These functions change x in place, one word at a time, reading the words
+ * past the end of y as 0. When y is longer than x, bitset_or and bitset_xor
+ * grow x to the length of y. They handle failure in the same way as array_cat.
+ *
+ * bitset_and and bitset_andnot never change the length of x: when y is
+ * shorter, bitset_and clears the words of x past the end of y, and
+ * bitset_andnot leaves them unchanged.
+ */
+
+/* x = x | y */
+void bitset_or(Array *x, Array *y);
+
+/* x = x & y. The words of x past the end of y are cleared. */
+void bitset_and(Array *x, Array *y);
+
+/* x = x ^ y */
+void bitset_xor(Array *x, Array *y);
+
+/* x = x & ~y. The words of x past the end of y are unchanged. */
+void bitset_andnot(Array *x, Array *y);
+
+/*
+ * Queries
+ * -------
+ */
+
+/* bitset_count returns the number of set bits in x. If x is unallocated,
+ * bitset_count returns 0. If x has failed, bitset_count returns -1. */
+int64_t bitset_count(Array *x);
+
+/* bitset_next returns the position of the first set bit at or after pos, or -1
+ * if there is none, if pos is negative or if x has failed. */
+int64_t bitset_next(Array *x, int64_t pos);
+
+/*
+ * Implementation notes:
+ *
+ * Storing 64 bit words rather than bytes keeps every operation a loop over
+ * words, and keeps the flags 8 times smaller than one byte per element.
+ *
+ * - bitset_count: popcnt on each word. With AVX2, use the nibble lookup
+ * (pshufb) popcount and accumulate with psadbw, which is faster than scalar
+ * popcnt above a few kilobytes.
+ * - bitset_next: mask off the bits below pos in the first word, then skip zero
+ * words (with AVX2, 4 at a time with vptest), and finish with tzcnt on the
+ * first non-zero word.
+ * - bulk operations: plain word loops, which compilers vectorize.
+ *
+ * Iterating with bitset_next costs one tzcnt per set bit plus one test per
+ * zero word, i.e. the speed of scanning the words themselves.
+ */
+
+#endif
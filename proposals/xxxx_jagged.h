@@ -0,0 +1,175 @@
+/*
+ * @lang: c89
+ * @taglist: ADT
+ * @dependencylist: xxxx_array
+ *
+ * Many small growable rows of bytes, packed together in a single array.
+ */
+
+/*
+ * The jagged library interface
+ * ----------------------------
+ *
+ * A jagged variable replaces a collection of small arrays, such as one list
+ * per entity. It follows the same rules as an array variable: it is either
+ * unallocated, allocated or failed, it must be initialized to all-0 before it
+ * is given to any of the jagged functions, and it must be returned to the
+ * unallocated (or failed) state with jagged_reset or jagged_fail before it is
+ * destroyed.
+ *
+ * It holds a number of rows, numbered starting at 0, each of which behaves
+ * like an array. All rows share the same two allocations, whatever their
+ * number. Every row starts at a multiple of JAGGED_ALIGNMENT bytes, so that
+ * rows may hold any scalar type, whatever was appended to the rows before
+ * them.
+ *
+ * @code{@lang{c}
+ * Jagged contacts = {0,};
+ * int64_t row = jagged_add_row(&contacts);
+ * uint64_t *other = jagged_allocate(&contacts, sizeof *other, row, 0);
+ * }
+ *
+ * Growing a row which has no spare room moves it to the end of the storage,
+ * leaving a hole behind. jagged_compact removes the holes, and puts the rows
+ * back in order, one after the other. Until the next growth, if the bytes of
+ * every row are a multiple of JAGGED_ALIGNMENT, all rows can then be iterated
+ * as a single range of bytes:
+ *
+ * @code{@lang{c}
+ * uint64_t const *first;
+ * int64_t i, n;
+ *
+ * jagged_compact(&contacts);
+ * first = jagged_start(&contacts);
+ * n = jagged_bytes(&contacts) / sizeof *first;
+ * for (i = 0; i < n; i++) {
+ *     visit(first[i]);
+ * }
+ * }
+ */
+
+#ifndef XXXX_JAGGED_H
+#define XXXX_JAGGED_H
+
+#include "xxxx_array.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Alignment of the start of every row, that of the largest scalar types. */
+enum { JAGGED_ALIGNMENT = 8 };
+
+/* The jagged variable. Its fields are private; they are only exposed so that
+ * jagged variables can be declared and initialized to all-0. Its state is the
+ * state of rows: unallocated, failed or allocated. */
+struct JaggedHeader {
+    /* (offset, bytes, capacity) triples of int64_t, one per row. */
+    Array rows;
+    /* The bytes of all rows. */
+    Array data;
+    /* Bytes of data no longer used by any row. */
+    int64_t garbage;
+    /* Nonzero while the rows follow each other in order, with no padding. */
+    int compact;
+};
+typedef struct JaggedHeader Jagged;
+
+/*
+ * Rows
+ * ----
+ */
+
+/* jagged_add_row adds an empty row to x and returns its number.
+ *
+ * If something goes wrong, jagged_add_row returns -1, setting errno
+ * appropriately, without touching x. */
+int64_t jagged_add_row(Jagged *x);
+
+/* jagged_rows returns the number of rows in x. If x is unallocated,
+ * jagged_rows returns 0. If x has failed, jagged_rows returns -1. */
+int64_t jagged_rows(Jagged *x);
+
+/*
+ * Expansion and inspection
+ * ------------------------
+ *
+ * These functions behave like the array function of the same name, applied to
+ * the given row. They also fail, in the same way, if row is not between 0 and
+ * jagged_rows-1.
+ *
+ * The pointers they return can continue to be used through subsequent calls to
+ * jagged_get, jagged_row_start, jagged_row_bytes, jagged_start, jagged_bytes
+ * and jagged_rows, but they must not be used after any other operations on x.
+ */
+
+void *
+jagged_allocate(Jagged *x, size_t element_size, int64_t row, int64_t pos);
+void *jagged_get(Jagged *x, size_t element_size, int64_t row, int64_t pos);
+void *jagged_row_start(Jagged *x, int64_t row);
+int64_t jagged_row_bytes(Jagged *x, int64_t row);
+void jagged_catb(Jagged *x, int64_t row, char const *y, size_t len);
+void jagged_truncate(Jagged *x, size_t element_size, int64_t row, size_t len);
+
+/*
+ * Compaction and iteration
+ * ------------------------
+ */
+
+/* jagged_compact moves the rows of x next to each other, in row order, and
+ * returns nonzero. Rows keep their number and their contents. Each row starts
+ * at the first multiple of JAGGED_ALIGNMENT after the end of the previous one,
+ * so rows are only separated by the padding needed for that.
+ *
+ * If something goes wrong, jagged_compact returns 0, setting errno
+ * appropriately, without touching x. */
+int jagged_compact(Jagged *x);
+
+/* If x is compact, i.e. no row has changed size since the last
+ * jagged_compact, and no row needed padding, i.e. the bytes of every row but
+ * the last are a multiple of JAGGED_ALIGNMENT, jagged_start returns a pointer
+ * to the first byte of row 0 and jagged_bytes returns the number of
+ * initialized bytes of all rows, which follow each other from there.
+ *
+ * Otherwise jagged_start returns 0 and jagged_bytes returns -1. */
+void *jagged_start(Jagged *x);
+int64_t jagged_bytes(Jagged *x);
+
+/*
+ * Deallocation
+ * ------------
+ */
+
+/* jagged_reset and jagged_fail are like array_reset and array_fail, and also
+ * remove all rows. */
+void jagged_reset(Jagged *x);
+void jagged_fail(Jagged *x);
+
+/*
+ * Implementation notes:
+ *
+ * A JaggedHeader holds two Arrays: one of (offset, bytes, capacity) triples
+ * indexed by row, and one holding the bytes of all rows. That is 24 bytes of
+ * overhead per row, against a heap block (16 bytes or more of allocator
+ * overhead, plus rounding) and an array header per individual array.
+ *
+ * Row offsets and capacities are multiples of JAGGED_ALIGNMENT, and the data
+ * array comes from malloc, which aligns it for any scalar type, so a row keeps
+ * its alignment however many bytes were appended to the others with
+ * jagged_catb. A row grows in place while it has capacity. Otherwise it is
+ * copied to the end of the data array with twice its capacity, and the bytes
+ * it leaves behind are counted as garbage. The last row in the data array can
+ * always grow in place. When the garbage exceeds half of the data array, the
+ * next growth compacts instead of growing the data array.
+ *
+ * jagged_compact copies the rows, in order, into a new data array allocated to
+ * the exact total size, padding each row to JAGGED_ALIGNMENT, and drops the
+ * spare capacity of every row. It clears the compact flag if any row needed
+ * padding.
+ *
+ * The benchmark builds 10K rows of 0 to 64 eight-byte elements, in random
+ * append order, as a jagged and as 10K arrays, and compares the memory used
+ * (from malloc statistics) and the time to sum all elements, before and after
+ * compaction.
+ */
+
+#endif
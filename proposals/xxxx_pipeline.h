@@ -0,0 +1,122 @@
+/*
+ * @lang: c89
+ * @taglist: concurrency
+ * @dependencylist: xxxx_tasks
+ *
+ * A pipeline of serial and parallel stages through which items stream, run by
+ * the task system, with a bound on the number of items in flight.
+ */
+
+/*
+ * The pipeline interface
+ * ----------------------
+ *
+ * The first stage produces items, e.g. by reading files. Each following stage
+ * receives the item returned by the previous stage, and returns the item for
+ * the next one. A stage may return the item it received, or a new one.
+ *
+ * - Serial stages process one item at a time, in the order the first stage
+ * produced them.
+ * - Parallel stages process any number of items at once, in any order.
+ *
+ * At most max_tokens items are in flight, i.e. produced by the first stage and
+ * not yet returned by the last one. The first stage is only called while fewer
+ * than max_tokens items are in flight, which provides back-pressure and bounds
+ * the memory used by items.
+ *
+ * @code{@lang{c}
+ * struct Pipeline *assets = pipeline_create(8);
+ *
+ * pipeline_add_stage(assets, PIPELINE_SERIAL, read_next_file, &catalog);
+ * pipeline_add_stage(assets, PIPELINE_PARALLEL, decompress, 0);
+ * pipeline_add_stage(assets, PIPELINE_PARALLEL, decode, 0);
+ * pipeline_add_stage(assets, PIPELINE_SERIAL, upload, &gpu);
+ *
+ * task_start(pipeline_task(assets, level_loaded));
+ * }
+ */
+
+#ifndef XXXX_PIPELINE_H
+#define XXXX_PIPELINE_H
+
+#include "xxxx_tasks.h"
+
+#include <stdint.h>
+
+struct Pipeline;
+
+enum { PIPELINE_MAX_STAGES = 8 };
+
+enum pipeline_stage_kind {
+    PIPELINE_SERIAL,
+    PIPELINE_PARALLEL
+};
+
+/* A stage, called with the item returned by the previous stage. The first
+ * stage is called with a null item, and returns a null item once there are no
+ * more items. The item returned by the last stage is ignored. */
+typedef void *(*pipeline_stage_function_t)(void *item, void *user_data);
+
+/* Create an empty pipeline with up to max_tokens items in flight, and returns
+ * it. Returns 0 on allocation error. */
+struct Pipeline *pipeline_create(int max_tokens);
+
+/* Add a stage at the end of the pipeline, which must not be running. The first
+ * stage must be serial, and a pipeline has at most PIPELINE_MAX_STAGES stages.
+ * Returns zero if the stage could not be added. */
+int pipeline_add_stage(struct Pipeline *pipeline,
+                       enum pipeline_stage_kind kind,
+                       pipeline_stage_function_t stage_function,
+                       void *user_data);
+
+/* Create the task running the pipeline until the first stage has no more
+ * items and all items have left the last stage, and returns it. The task
+ * `then` is started afterwards, unless it is the null task. A pipeline runs
+ * once at a time; it can run again after `then` has started.
+ *
+ * A null handle denotes an allocation error. */
+task_t pipeline_task(struct Pipeline *pipeline, task_t then);
+
+struct pipeline_stats {
+    uint64_t items;
+    /* Largest number of items in flight at once. */
+    int peak_tokens;
+    /* Time spent by all calls of each stage, and time items spent waiting for
+     * a serial stage. Indexed by stage. */
+    uint64_t stage_nanoseconds[PIPELINE_MAX_STAGES];
+    uint64_t wait_nanoseconds[PIPELINE_MAX_STAGES];
+};
+
+/* Read the statistics of the last run, which must have completed. */
+void pipeline_get_stats(struct Pipeline *pipeline,
+                        struct pipeline_stats *stats);
+
+/* Free the pipeline, which must not be running. */
+void pipeline_free(struct Pipeline *pipeline);
+
+/*
+ * Implementation notes:
+ *
+ * Each item in flight is a token: a small record holding the item, its
+ * sequence number and the next stage. A token is a task, which runs stages one
+ * after the other for as long as they are parallel, or serial and free.
+ *
+ * A serial stage holds a sequence number and a small ring of tokens waiting
+ * for their turn. A token reaching a serial stage out of order parks in the
+ * ring and its task returns; the token leaving the stage starts the task of the
+ * next waiting token, if it is the next in order.
+ *
+ * At startup, the first stage runs once per token until max_tokens items are
+ * in flight or it has no more items. After that, a token leaving the last stage
+ * goes back to the first stage instead of being freed, which is the
+ * back-pressure: the first stage is never called with all max_tokens in
+ * flight. Tokens are allocated with the pipeline, so a
+ * run performs no allocation.
+ *
+ * The benchmark runs a synthetic read/decompress/decode/upload pipeline, with
+ * stage costs of 1:4:8:1 and items of 1MB, for max_tokens from 1 to 4 times the
+ * number of workers, and reports items per second and peak_tokens times the
+ * item size as the peak memory.
+ */
+
+#endif
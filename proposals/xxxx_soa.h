@@ -0,0 +1,169 @@
+/*
+ * @lang: c89
+ * @taglist: ADT
+ * @dependencylist: xxxx_array
+ *
+ * A growable structure of arrays: up to SOA_MAX_FIELDS arrays, one per field,
+ * which always have the same length and grow together.
+ */
+
+/*
+ * The soa library interface
+ * -------------------------
+ *
+ * A soa variable follows the same rules as an array variable: it is either
+ * unallocated, allocated or failed, it must be initialized to all-0 before it
+ * is given to any of the soa functions, and it must be returned to the
+ * unallocated (or failed) state with soa_reset or soa_fail before it is
+ * destroyed.
+ *
+ * Before it is allocated for the first time, its fields are declared with
+ * soa_define. Each field then behaves like an array with its own element size,
+ * but all fields share a single length: element i of the soa is made of
+ * element i of every field.
+ *
+ * @code{@lang{c}
+ * enum { POSITION_X, POSITION_Y, VISIBLE, ENTITY_FIELDS };
+ * size_t const entity_sizes[ENTITY_FIELDS] = {
+ *     sizeof(float), sizeof(float), sizeof(uint8_t)};
+ *
+ * Soa entities = {0,};
+ * soa_define(&entities, ENTITY_FIELDS, entity_sizes);
+ *
+ * soa_allocate(&entities, soa_length(&entities));
+ * }
+ *
+ * Loops which only read a few fields then only touch the memory of those
+ * fields:
+ *
+ * @code{@lang{c}
+ * float *x = soa_field(&entities, POSITION_X);
+ * float const *y = soa_field(&entities, POSITION_Y);
+ * int64_t i, n = soa_length(&entities);
+ *
+ * for (i = 0; i < n; i++) {
+ *     x[i] += y[i];
+ * }
+ * }
+ */
+
+#ifndef XXXX_SOA_H
+#define XXXX_SOA_H
+
+#include "xxxx_array.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+    SOA_MAX_FIELDS = 16,
+    SOA_ALIGNMENT = 64
+};
+
+/* The soa variable. Its fields are private; they are only exposed so that
+ * soas can be declared and initialized to all-0.
+ *
+ * - unallocated: length and capacity are 0, and no field array is allocated.
+ * - failed: length is -1.
+ * - allocated: capacity is positive. */
+struct SoaHeader {
+    int64_t length;
+    int64_t capacity;
+    int field_count;
+    size_t element_sizes[SOA_MAX_FIELDS];
+    /* Offset of the aligned first element in each field array. */
+    size_t offsets[SOA_MAX_FIELDS];
+    Array fields[SOA_MAX_FIELDS];
+};
+typedef struct SoaHeader Soa;
+
+/*
+ * Definition
+ * ----------
+ */
+
+/* soa_define declares field_count fields whose elements are
+ * element_sizes[0], element_sizes[1], ..., element_sizes[field_count-1] bytes
+ * long, and returns nonzero. (Each size must be positive; otherwise the effects
+ * are undefined.)
+ *
+ * soa_define returns 0, setting errno to EINVAL, without touching x, if x is
+ * not unallocated or if field_count is not between 1 and SOA_MAX_FIELDS. An
+ * unallocated soa keeps its fields after soa_reset, so they only need to be
+ * declared once. */
+int soa_define(Soa *x, int field_count, size_t const *element_sizes);
+
+/*
+ * Expansion and inspection
+ * ------------------------
+ */
+
+/* soa_allocate makes sure that every field of x has at least pos+1 elements
+ * allocated and initialized, like array_allocate does for a single array. The
+ * new elements are set to 0. It returns nonzero.
+ *
+ * If something goes wrong, soa_allocate returns 0, setting errno
+ * appropriately, without touching x. In particular, soa_allocate returns 0 if:
+ * - x has failed, or
+ * - no field was declared, or
+ * - pos is negative, or
+ * - not enough memory is available for any of the fields. */
+int soa_allocate(Soa *x, int64_t pos);
+
+/* soa_field returns a pointer to the first element of the given field, or 0
+ * if x is not allocated or the field was not declared.
+ *
+ * The pointer is aligned to SOA_ALIGNMENT bytes, and the field is padded with
+ * allocated bytes up to the next multiple of SOA_ALIGNMENT, so that SIMD loops
+ * may load (but not store) a full vector past the last element.
+ *
+ * The pointer can continue to be used through subsequent calls to soa_field
+ * and soa_length, but it must not be used after any other operations on x. */
+void *soa_field(Soa *x, int field);
+
+/* soa_length returns the number of elements in x. If x is unallocated,
+ * soa_length returns 0. If x has failed, soa_length returns -1. */
+int64_t soa_length(Soa *x);
+
+/*
+ * Removal and deallocation
+ * ------------------------
+ */
+
+/* soa_swap_remove moves the last element of x over element pos, in every
+ * field, then reduces the length of x by 1. It has no effect if pos is not
+ * between 0 and soa_length-1. */
+void soa_swap_remove(Soa *x, int64_t pos);
+
+/* soa_truncate reduces the length of x to exactly len, like array_truncate. It
+ * does not change the allocation in x. */
+void soa_truncate(Soa *x, int64_t len);
+
+/* soa_reset and soa_fail are like array_reset and array_fail, applied to every
+ * field. */
+void soa_reset(Soa *x);
+void soa_fail(Soa *x);
+
+/*
+ * Implementation notes:
+ *
+ * A SoaHeader holds the shared length and capacity, the declared element
+ * sizes, and one Array per field. Growth follows array_allocate, but is decided
+ * once for all fields: when the capacity is exceeded, every field is grown to
+ * the same new capacity. If one of them fails to grow, the fields already grown
+ * keep their larger allocation but the length is unchanged, so x is untouched
+ * as far as the caller can tell.
+ *
+ * Each field Array over-allocates by SOA_ALIGNMENT-1 bytes plus the tail
+ * padding, and soa_field returns the first aligned address inside it. realloc
+ * does not keep the alignment of the region, so after every reallocation the
+ * aligned offset is recomputed and, when it changed, the initialized elements
+ * are moved with memmove from the old offset to the new one.
+ *
+ * The benchmark compares loops over 1 and 2 fields of 4 byte elements out of an
+ * entity of 64 bytes, stored as a soa and as an array of structs, from 1K
+ * entities (in cache) to 10M entities (in memory). The soa version should only
+ * read the bytes of the fields it uses, and vectorize.
+ */
+
+#endif
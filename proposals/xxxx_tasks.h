@@ -4,6 +4,12 @@
  * @taglist: concurrency
  */
 
+#ifndef XXXX_TASKS_H
+#define XXXX_TASKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
 typedef struct task_handle task_t;
 typedef void (*task_function_t)(void *task_data);
 
@@ -23,6 +29,500 @@ struct task_handle {
     int id;
 };
 
+/*
+ * Cancellation
+ * ------------
+ *
+ * A cancellation token is shared by a group of tasks, e.g. all the streaming
+ * tasks of a level. Cancelling the token aborts all of them at once.
+ *
+ * @code{@lang{c}
+ * task_token_t level = task_token_create(TASK_CANCEL_PROPAGATE);
+ * task_t read = task_create(read_chunk, chunk);
+ *
+ * task_attach_token(read, level);
+ * task_start(read);
+ * ...
+ * task_cancel(level);
+ * }
+ */
+
+typedef struct task_token_handle task_token_t;
+
+/* What happens to the dependencies of a task which is cancelled before it
+ * started. */
+enum task_cancel_policy {
+    /* Dependencies are cancelled as well, whatever their token. */
+    TASK_CANCEL_PROPAGATE,
+    /* Dependencies are started as if the task had completed. */
+    TASK_CANCEL_RELEASE
+};
+
+/* Create a new cancellation token and returns its handle. A null handle
+ * denotes an allocation error. */
+task_token_t task_token_create(enum task_cancel_policy policy);
+
+/* Free the token. No task may refer to it anymore. */
+void task_token_free(task_token_t token);
+
+/* Attach the token to a task which has not been started yet. A task has at
+ * most one token. */
+void task_attach_token(task_t task, task_token_t token);
+
+/* Cancel all the tasks attached to the token: the ones which have not started
+ * running yet are skipped, and their dependencies treated according to the
+ * token's policy. Tasks attached after the token was cancelled are skipped
+ * too. Running tasks are not interrupted, but see task_cancelled. */
+void task_cancel(task_token_t token);
+
+/* Return nonzero if the token of the task currently running on this thread
+ * has been cancelled. Long task bodies poll it to stop early; a task which
+ * returns early still counts as completed. Costs a thread-local read and a
+ * relaxed atomic load. */
+int task_cancelled(void);
+
+/* Name for a cancellation token. The null token has id = 0. */
+struct task_token_handle {
+    int id;
+};
+
+/*
+ * Implementation notes for cancellation:
+ *
+ * A token is a slot with a cancelled flag, a policy, and the same
+ * index/generation id as tasks. A task stores the id of its token, and the
+ * scheduler checks the flag when popping the task, before calling its
+ * function. A skipped task follows the normal completion path (decrementing
+ * the counters of its dependencies) with a flag saying whether its dependencies
+ * should run or be skipped in turn.
+ *
+ * The worker keeps a pointer to the flag of the running task's token in a
+ * thread-local, which is all task_cancelled reads.
+ */
+
+/*
+ * Timers
+ * ------
+ *
+ * Tasks can be started at a later time by the scheduler itself, rather than by
+ * a timer thread. Times are in nanoseconds of the scheduler's monotonic clock.
+ *
+ * A task runs at most once; periodic work creates and schedules its next task
+ * from its own body:
+ *
+ * @code{@lang{c}
+ * void autosave(void *data)
+ * {
+ *     save_game(data);
+ *     task_start_after(task_create(autosave, data), AUTOSAVE_PERIOD_NS);
+ * }
+ * }
+ */
+
+/* Return the current time of the scheduler's clock. */
+uint64_t task_clock(void);
+
+/* Schedule the task to run as soon as possible once task_clock has reached
+ * time. A time in the past is the same as task_start. */
+void task_start_at(task_t task, uint64_t time);
+
+/* Schedule the task to run as soon as possible once delay nanoseconds have
+ * elapsed. */
+void task_start_after(task_t task, uint64_t delay);
+
+/*
+ * Implementation notes for timers:
+ *
+ * Pending timers live in a hierarchical timing wheel: 4 levels of 64 slots,
+ * with 1ms ticks at the first level, covering about 4.6 hours, plus an overflow
+ * list. Inserting is O(1): the task slot is linked into the slot's intrusive
+ * list, so 100k pending timers cost no memory beyond their tasks. Advancing a
+ * tick moves the tasks of one slot, and cascades the next level's slot down
+ * every 64 ticks.
+ *
+ * The wheel is advanced by workers, not by a thread of its own: a worker about
+ * to go idle compares the clock to the earliest deadline (a single atomic
+ * load), and if it is due, tries to take the wheel lock and starts the expired
+ * tasks. Cancelled tasks are skipped when they expire.
+ *
+ * So that timers fire within a tick even when no other work is running, one
+ * parked worker, the timekeeper, parks with a timeout (futex_wait's timeout)
+ * equal to the time left until the earliest deadline; the other workers park
+ * without one, so a deadline wakes a single worker. The role is a flag taken
+ * with a compare and swap by the first worker to park while timers are pending.
+ * The timekeeper gives it up when it finds a task to run, and then wakes one
+ * parked worker, if any, which takes the role as it parks again.
+ *
+ * The timekeeper waits on a futex word of its own, the timer epoch, rather than
+ * on the shared epoch. task_start increments both epochs, and wakes the
+ * timekeeper when futex_wake on the shared epoch woke nobody, which covers a
+ * single worker, or serial scheduling, where it is the only one. task_start_at
+ * lowers the earliest deadline with a compare and swap loop. When it did lower
+ * it, it increments the timer epoch and wakes the timekeeper, which parks again
+ * with the new timeout; if there is no timekeeper and the parked count is
+ * nonzero, it increments the epoch and wakes one worker, like task_start
+ * (@see{task_idle_policy}), which takes the role as it parks again.
+ */
+
+/*
+ * Idling
+ * ------
+ *
+ * A worker which finds no ready task first spins for a while, then parks until
+ * it is woken up. Starting tasks wakes at most as many parked workers as there
+ * are new ready tasks.
+ *
+ * @code{@lang{c}
+ * struct task_idle_policy idle;
+ * struct task_idle_stats stats;
+ *
+ * idle.spin_count = 2000;
+ * task_set_idle_policy(&idle);
+ * run_benchmark();
+ * task_get_idle_stats(&stats);
+ * printf("wakeup latency: %f ns\n",
+ *        (double)stats.wakeup_latency_nanoseconds / stats.wakeups);
+ * }
+ */
+
+struct task_idle_policy {
+    /* Number of polls of the ready queues, separated by a pause instruction,
+     * before parking. 0 parks immediately. */
+    uint32_t spin_count;
+};
+
+/* Set the idle policy of all workers. */
+void task_set_idle_policy(struct task_idle_policy const *policy);
+
+/* Counters summed over all workers since the scheduler started. */
+struct task_idle_stats {
+    /* Times a worker ran out of ready tasks. */
+    uint64_t idles;
+    /* Idles which ended during the spin, without parking. */
+    uint64_t spin_hits;
+    uint64_t parks;
+    uint64_t wakeups;
+    /* Wakeups after which the worker found no ready task. */
+    uint64_t futile_wakeups;
+    /* Time spent spinning, and time spent parked. */
+    uint64_t spin_nanoseconds;
+    uint64_t park_nanoseconds;
+    /* Sum of the delays between a wakeup request and the woken worker
+     * running, to be divided by wakeups. */
+    uint64_t wakeup_latency_nanoseconds;
+};
+
+/* Read the idle counters. */
+void task_get_idle_stats(struct task_idle_stats *stats);
+
+/*
+ * Implementation notes for idling:
+ *
+ * Parking uses an eventcount on top of a futex (WaitOnAddress on win32), so
+ * that a wakeup cannot be lost between the last poll and the wait:
+ * - the worker increments the parked count (seq_cst), then reads the epoch,
+ * polls the queues one last time, and calls futex_wait on the epoch with the
+ * value it read, or on the timer epoch with a timeout if it is the timekeeper
+ * (@see{task_start_at}). If the poll finds a task, it decrements the parked
+ * count and runs it instead;
+ * - task_start pushes the task, issues a full fence, then, only if the parked
+ * count is nonzero (one load in the common, busy case), increments the epoch
+ * and calls futex_wake with a count of 1. task_depends completions and batch
+ * starts wake as many workers as they made tasks ready, capped by the parked
+ * count.
+ *
+ * Either the producer's load sees the worker's increment, and the epoch
+ * changes so futex_wait returns immediately, or the worker's final poll sees
+ * the producer's push: the fences order the increment before the poll, and the
+ * push before the load.
+ *
+ * A woken worker which finds a task, and still sees parked workers and more
+ * ready tasks, wakes one more, so wakeups spread as a tree rather than all from
+ * the producer.
+ *
+ * The default spin_count is calibrated at startup to about 20us: longer than
+ * a futex round trip, short enough that idle workers use little CPU. The
+ * benchmark reports the wakeup latency and the spin time per second of
+ * wall-clock (idle CPU usage) for spin counts from 0 to 100us, on a
+ * producer/consumer ping-pong and on bursts of short tasks.
+ */
+
+/*
+ * Child tasks
+ * -----------
+ *
+ * A running task may spawn children. The task then only completes, i.e. its
+ * dependencies are only started, once its function has returned and all its
+ * children have completed. Children may spawn children of their own, so a task
+ * completes after its whole subtree.
+ *
+ * @code{@lang{c}
+ * void decode_level(void *data)
+ * {
+ *     struct Level *level = data;
+ *     int i;
+ *     for (i = 0; i < level->chunk_count; i++) {
+ *         task_spawn_child(decode_chunk, &level->chunks[i]);
+ *     }
+ *     task_continue_with(link_level, level);
+ * }
+ * }
+ */
+
+/* Create a child of the task running on this thread, and start it. Returns
+ * the child's handle. A null handle denotes an allocation error, or that no
+ * task is running on this thread.
+ *
+ * The child is already started, so its handle must not be given to
+ * task_depends: as `task`, the child may have completed before the edge is
+ * added, and `dependency` would never start; as `dependency`, it would be
+ * started twice. Work which needs the children's results goes in
+ * task_continue_with.
+ *
+ * The child inherits the cancellation token of its parent (@see{task_cancel}):
+ * cancelling the token skips the children which have not started, and makes
+ * task_cancelled return nonzero in the running ones. A skipped child counts as
+ * completed for its parent. */
+task_t task_spawn_child(task_function_t task_function, void *task_data);
+
+/* Run task_function once all the children of the task running on this thread
+ * have completed, as the last part of that task: its dependencies are started
+ * after task_function returns. The continuation may itself spawn children and
+ * set a continuation. Returns zero, without setting a continuation, if no task
+ * is running on this thread or it already has one. */
+int task_continue_with(task_function_t task_function, void *task_data);
+
+/*
+ * Implementation notes for child tasks:
+ *
+ * Each task holds a pending count, initialized to 1 for the task's own
+ * function. Spawning a child increments the parent's count and stores the
+ * parent's index in the child's slot. When a function returns, or a child
+ * completes, the count is decremented; at zero, the continuation (if any) is
+ * run with the count reset to 1, otherwise the task completes, which starts
+ * its dependencies and decrements its own parent's count.
+ *
+ * A child copies its parent's token id into its own record when spawned, so the
+ * cancellation check when popping it is the same as for any other task.
+ *
+ * Children take their slots from the same table as task_create, and the
+ * pending count, parent index and continuation are stored in the task's cold
+ * record (@see{task_create_inline}), so the common case performs no heap
+ * allocation. Children are pushed on the spawning worker's own queue,
+ * where they are likely to run while their inputs are still in cache.
+ */
+
+/*
+ * Bulk creation
+ * -------------
+ *
+ * Building large graphs one task and one edge at a time pays a call and an
+ * atomic operation per node and per edge. These functions create and wire many
+ * tasks at once.
+ *
+ * @code{@lang{c}
+ * struct task_range blocks = task_create_n(cull_block, block_data,
+ *                                          sizeof *block_data, block_count);
+ * task_t merge = task_create(merge_visible, visible);
+ *
+ * task_depends_all(blocks, merge);
+ * task_start_n(blocks);
+ * }
+ */
+
+/* A contiguous range of n tasks. */
+struct task_range {
+    task_t first;
+    int n;
+};
+
+/* Create n tasks calling task_function, task i receiving task_data + i *
+ * task_data_stride as its data. Returns their range, whose handles are
+ * contiguous.
+ *
+ * A range with a null first handle denotes that no task was created: either an
+ * allocation error, or that no run of n contiguous free slots is available.
+ * The caller may then fall back to task_create, one task at a time. */
+struct task_range task_create_n(task_function_t task_function,
+                                void *task_data,
+                                size_t task_data_stride,
+                                int n);
+
+/* Return the handle of task i of the range. */
+task_t task_range_at(struct task_range range, int i);
+
+/* Mark that each of the n tasks in `dependencies` depends on `task` (fan-out.)
+ * Same as calling task_depends for each of them. */
+void task_depends_many(task_t task, task_t const *dependencies, int n);
+
+/* Mark that `dependency` depends on every task of the range (fan-in.) Same as
+ * calling task_depends for each task of the range, which must not have been
+ * started yet: use task_depends for ranges already started. */
+void task_depends_all(struct task_range range, task_t dependency);
+
+/* Schedule all the tasks of the range. */
+void task_start_n(struct task_range range);
+
+/*
+ * Implementation notes for bulk creation:
+ *
+ * Ranges come from a fixed region of the task table, e.g. its upper half,
+ * which the free list never covers: task_create only pops slots of the other
+ * region, and slots of the range region go back to the free state, not to the
+ * free list, when their task completes. So task_create can never be handed a
+ * slot of a range.
+ *
+ * task_create_n reserves n consecutive slots of the range region with a
+ * compare-and-swap on its allocation cursor, which sweeps the region as a
+ * ring; the run must not cross the end of the region. It then claims each slot
+ * with a compare-and-swap of its state from free to claimed, which fails if
+ * the slot is still used by a task from an earlier lap of the cursor. If any
+ * claim fails, the slots already claimed are set back to free, the cursor
+ * skips past the failed slot, and task_create_n tries once more, then gives up
+ * and returns a null range.
+ *
+ * Every slot of the run then gets the same generation: one more than the
+ * largest generation among them, which still increases the generation of each
+ * slot for use-after-free detection. Handles of a range thus only differ by
+ * their index, and task_range_at is an addition. The slots are not visible to
+ * any other thread until they are started or wired, so they are initialized
+ * with plain stores.
+ *
+ * task_depends_all adds n to the dependency's pending counter with one atomic
+ * add, and appends the edges to each task of the range with plain stores: the
+ * tasks of a range which has not been started still belong to the calling
+ * thread, as no other thread can complete them. task_start_n pushes
+ * the whole range to the ready queue with one publication and wakes at most n
+ * workers.
+ *
+ * The benchmark builds and runs graphs of 10k empty tasks (a fan-out/fan-in,
+ * and a layered graph with 4 edges per node), with the single-task and the
+ * bulk functions, and reports build time per node and per edge.
+ */
+
+/*
+ * Inline data
+ * -----------
+ *
+ * Small task data can be copied into the task itself, instead of being
+ * allocated by the caller and freed by the task.
+ *
+ * @code{@lang{c}
+ * struct DecodeArgs args;
+ * args.chunk = chunk;
+ * args.target = target;
+ * task_start(task_create_inline(decode, &args, sizeof args));
+ * }
+ */
+
+enum {
+    /* Maximum number of bytes of inline task data. */
+    TASK_INLINE_DATA_MAX = 48,
+    /* Alignment of the inline copy. */
+    TASK_INLINE_DATA_ALIGNMENT = 16
+};
+
+/* Create a new task and returns its handle, like task_create. The size bytes
+ * at task_data are copied into the task, and the copy is what task_function
+ * receives. It remains valid until task_function returns.
+ *
+ * A null handle denotes an allocation error, or a size larger than
+ * TASK_INLINE_DATA_MAX. */
+task_t task_create_inline(task_function_t task_function,
+                          void const *task_data,
+                          size_t size);
+
+/*
+ * Implementation notes for inline data:
+ *
+ * A task is split in two records with the same index, in two tables:
+ *
+ * - the hot slot, 64 bytes and aligned to 64 bytes, is what a worker reads to
+ * run the task: the function pointer (8 bytes), the generation and flags (4
+ * bytes), the count of unfinished predecessors (4 bytes), then 48 bytes which
+ * hold either the task_data pointer or the inline data. The inline data thus
+ * shares the cache line of the function pointer.
+ * - the cold record, also 64 bytes, holds everything else: the head of the
+ * dependency edge list (4 bytes), the cancellation token id (4 bytes), the
+ * parent index and pending children count of child tasks (8 bytes), the
+ * continuation function and data (16 bytes), and the timing wheel links and
+ * deadline (16 bytes).
+ *
+ * The flags say which parts of the cold record are in use (token, parent,
+ * continuation, timer), so running a plain task never touches it. Children
+ * decrement their parent's pending count in the cold record, which also keeps
+ * those atomics off the line other workers read to run the parent.
+ *
+ * That is more than the 16/24 bytes of a minimal task, but it saves the
+ * caller's allocation (and the task's free), which costs more than the extra
+ * bytes for small tasks.
+ */
+
+/*
+ * Scheduling modes
+ * ----------------
+ *
+ * For profiling, the scheduler can trade throughput for reproducibility, with
+ * the same task_create, task_depends and task_start calls:
+ *
+ * - TASK_SCHEDULE_PARALLEL: the default, all workers steal work from each
+ * other as soon as they are idle.
+ * - TASK_SCHEDULE_SERIAL: a single worker runs all tasks, in a deterministic
+ * topological order: ready tasks run first in, first out, in the order they
+ * were started or made ready. The same graph runs in the same order every
+ * time.
+ * - TASK_SCHEDULE_SEEDED: worker_count workers, each stealing from victims in
+ * an order drawn from a generator seeded with seed. This removes the
+ * randomness of victim selection, but not the timing of the workers, so the
+ * order is reproducible only as far as the tasks' durations are.
+ *
+ * Profiling one frame in serial mode, between two parallel frames:
+ *
+ * @code{@lang{c}
+ * struct task_schedule serial = {0}, parallel = {0};
+ *
+ * serial.mode = TASK_SCHEDULE_SERIAL;
+ * task_set_schedule(&serial);
+ * run_frame();
+ *
+ * parallel.mode = TASK_SCHEDULE_PARALLEL;
+ * task_set_schedule(&parallel);
+ * }
+ *
+ * Defining TASK_SCHEDULE_DEFAULT_SERIAL when compiling the task system makes
+ * TASK_SCHEDULE_SERIAL the default mode.
+ */
+
+enum task_schedule_mode {
+    TASK_SCHEDULE_PARALLEL,
+    TASK_SCHEDULE_SERIAL,
+    TASK_SCHEDULE_SEEDED
+};
+
+struct task_schedule {
+    enum task_schedule_mode mode;
+    /* TASK_SCHEDULE_SEEDED only. 0 means all workers. */
+    int worker_count;
+    uint64_t seed;
+};
+
+/* Set the scheduling mode. Must be called while no task is running or ready,
+ * e.g. between frames. */
+void task_set_schedule(struct task_schedule const *schedule);
+
+/*
+ * Implementation notes for scheduling modes:
+ *
+ * The serial mode pins all work to worker 0 through a single FIFO queue, and
+ * parks the other workers, so that the worker threads and their stacks remain
+ * the same as in parallel mode. Timers expire in deadline order, ties broken
+ * by start order.
+ *
+ * The seeded mode gives each worker a xorshift generator seeded with seed and
+ * its index, used for victim selection only, and keeps the workers beyond
+ * worker_count parked.
+ */
+
 /*
  * Implementation notes from Per Vognsen:
  *
@@ -51,4 +551,6 @@ struct task_handle {
  *
  * Don't try to make batching the job of the task system. The right strategy is
  * tied up with your data design.
- */
\ No newline at end of file
+ */
+
+#endif
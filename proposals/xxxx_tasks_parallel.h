@@ -0,0 +1,166 @@
+/*
+ * @lang: c89
+ * @taglist: concurrency, algorithm
+ * @dependencylist: xxxx_tasks
+ *
+ * Parallel reduction and exclusive prefix scan over a range of elements, as
+ * graphs of tasks.
+ */
+
+/*
+ * The caller chooses how many blocks the range is split into (task_count): in
+ * the spirit of the task system, it is up to the data design to make each
+ * block worth a task.
+ *
+ * Both operations are described by a block function, which processes a
+ * contiguous block of elements serially, and an associative combine function,
+ * which merges two partial results. Partials are combined in block order, so
+ * the combine function does not need to be commutative.
+ *
+ * @code{@lang{c}
+ * void histogram_block(void *partial, void const *first, size_t n, void *user)
+ * {
+ *     uint32_t *bins = partial;
+ *     uint8_t const *values = first;
+ *     size_t i;
+ *     for (i = 0; i < n; i++) {
+ *         bins[values[i]]++;
+ *     }
+ * }
+ *
+ * void histogram_combine(void *x, void const *y, void *user)
+ * {
+ *     uint32_t *bins = x;
+ *     uint32_t const *other = y;
+ *     int i;
+ *     for (i = 0; i < 256; i++) {
+ *         bins[i] += other[i];
+ *     }
+ * }
+ *
+ * uint32_t bins[256], zero_bins[256] = {0};
+ * struct task_reduce histogram = {0};
+ *
+ * histogram.first = values;
+ * histogram.n = value_count;
+ * histogram.element_size = 1;
+ * histogram.result = bins;
+ * histogram.result_size = sizeof bins;
+ * histogram.identity = zero_bins;
+ * histogram.block = histogram_block;
+ * histogram.combine = histogram_combine;
+ *
+ * task_start(task_parallel_reduce(&histogram, 64, display_histogram));
+ * }
+ */
+
+#ifndef XXXX_TASKS_PARALLEL_H
+#define XXXX_TASKS_PARALLEL_H
+
+#include "xxxx_tasks.h"
+
+#include <stddef.h>
+
+/* Accumulate the n elements at first into partial. */
+typedef void (*task_block_function_t)(void *partial,
+                                      void const *first,
+                                      size_t n,
+                                      void *user_data);
+
+/* Combine the partial y into x, i.e. x = x op y. */
+typedef void (*task_combine_function_t)(void *x,
+                                        void const *y,
+                                        void *user_data);
+
+/* Write the exclusive scan of the n elements at first to out, starting from
+ * carry: out[0] = carry, out[i] = carry op first[0] op ... op first[i-1]. */
+typedef void (*task_scan_function_t)(void *out,
+                                     void const *first,
+                                     size_t n,
+                                     void const *carry,
+                                     void *user_data);
+
+/*
+ * Reduction
+ * ---------
+ */
+
+struct task_reduce {
+    /* The n elements to reduce, each element_size bytes long. */
+    void const *first;
+    size_t n;
+    size_t element_size;
+    /* The result, result_size bytes long, and its identity value. */
+    void *result;
+    size_t result_size;
+    void const *identity;
+    task_block_function_t block;
+    task_combine_function_t combine;
+    void *user_data;
+};
+
+/* Create the tasks reducing the elements into the result, over up to
+ * task_count blocks, and returns the task which starts them. Once the result
+ * is written, the task `then` is started, unless it is the null task.
+ *
+ * The description is copied; the elements and the result must stay valid until
+ * `then` has started. A null handle denotes an allocation error. */
+task_t task_parallel_reduce(struct task_reduce const *reduce,
+                            int task_count,
+                            task_t then);
+
+/*
+ * Scan
+ * ----
+ */
+
+struct task_scan {
+    /* The n elements to scan, each element_size bytes long. */
+    void const *first;
+    size_t n;
+    size_t element_size;
+    /* The n outputs, each result_size bytes long, and the identity value. */
+    void *out;
+    size_t result_size;
+    void const *identity;
+    task_block_function_t block;
+    task_combine_function_t combine;
+    task_scan_function_t scan;
+    void *user_data;
+};
+
+/* Create the tasks writing the exclusive scan of the elements to out, over up
+ * to task_count blocks, and returns the task which starts them. Once out is
+ * written, the task `then` is started, unless it is the null task.
+ *
+ * The description is copied; the elements and out must stay valid until `then`
+ * has started. out may be the same memory as the elements when element_size is
+ * result_size. A null handle denotes an allocation error. */
+task_t task_parallel_scan(struct task_scan const *scan,
+                          int task_count,
+                          task_t then);
+
+/*
+ * Implementation notes:
+ *
+ * The partials are allocated with the tasks, one per block, each rounded up to
+ * a multiple of 64 bytes and aligned to 64 bytes, so that no two blocks write
+ * to the same cache line.
+ *
+ * Reduction: every block task initializes its partial from the identity and
+ * calls the block function; a final task, depending on all of them, combines
+ * the partials in block order into the result.
+ *
+ * Scan (two-pass blocked scan): the first pass is the reduction of each block,
+ * without the final combine. A serial task then replaces the partials by their
+ * exclusive scan, i.e. the carry into each block. The second pass calls the
+ * scan function on every block with its carry. Elements are read twice, which
+ * is the price of a scan that scales; with fewer than two blocks, a single task
+ * calls the scan function on the whole range.
+ *
+ * Scaling is measured with sums, min/max and 256-bin histograms of 100M
+ * elements, and an exclusive scan of 100M 32 bit integers, with 1 to all
+ * workers and 1 to 16 blocks per worker.
+ */
+
+#endif
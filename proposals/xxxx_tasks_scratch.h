@@ -0,0 +1,101 @@
+/*
+ * @lang: c89
+ * @taglist: concurrency, memory
+ * @dependencylist: xxxx_tasks, xxxx_array
+ *
+ * A scratch arena per worker, for the temporary allocations of task bodies.
+ */
+
+/*
+ * The scratch interface
+ * ---------------------
+ *
+ * Each worker owns a bump arena. Everything a task allocates from it is
+ * released when the task function returns, so temporaries need no free and no
+ * worker contends with another for the allocator.
+ *
+ * Longer tasks can release memory earlier with a mark: allocations made after
+ * task_arena_mark are released by task_arena_release.
+ *
+ * Arrays can allocate from the arena too. They must be reset, or no longer
+ * used, before the task function returns.
+ *
+ * @code{@lang{c}
+ * void cull_block(void *data)
+ * {
+ *     struct task_arena *scratch = task_scratch();
+ *     Array visible = {0,};
+ *
+ *     array_use_arena(&visible, task_arena_array_arena(scratch));
+ *     cull(data, &visible);
+ *     submit(array_start(&visible), array_bytes(&visible));
+ *     array_reset(&visible);
+ * }
+ * }
+ */
+
+#ifndef XXXX_TASKS_SCRATCH_H
+#define XXXX_TASKS_SCRATCH_H
+
+#include "xxxx_array.h"
+#include "xxxx_tasks.h"
+
+#include <stddef.h>
+
+struct task_arena;
+
+/* A position in an arena. */
+struct task_arena_mark {
+    size_t offset;
+};
+
+/* Return the arena of the worker running the current task, or 0 if no task is
+ * running on this thread. */
+struct task_arena *task_scratch(void);
+
+/* Allocate size bytes aligned to alignment, a power of two, and returns them.
+ * Returns 0 if not enough memory is available, or if the allocation would go
+ * past the end of the arena's reservation. */
+void *task_arena_alloc(struct task_arena *arena, size_t size, size_t alignment);
+
+/* Return the current position of the arena. */
+struct task_arena_mark task_arena_mark(struct task_arena *arena);
+
+/* Release all allocations made since mark was taken, including the regions of
+ * arrays allocated from the arena.
+ *
+ * This includes the region of an array created before the mark, if the array
+ * grew after it: growing may copy the region to a new allocation, which the
+ * release frees, leaving the array pointing at released memory. Arrays created
+ * before a mark must therefore not grow until the mark is released. */
+void task_arena_release(struct task_arena *arena, struct task_arena_mark mark);
+
+/* Return an array arena allocating from arena, for array_use_arena. */
+struct ArrayArena *task_arena_array_arena(struct task_arena *arena);
+
+/*
+ * Implementation notes:
+ *
+ * Each worker reserves a large range of address space (e.g. 1GB) for its
+ * arena at startup and commits it in 64KB steps as the bump pointer advances,
+ * so the arena never moves. Allocations which would go past the reservation
+ * fail, as do the arrays growing from it, rather than falling back to the
+ * heap: a task needing more than that should allocate from the heap itself.
+ *
+ * The worker takes a mark before calling each task function and releases it
+ * afterwards; pages past a high water mark are decommitted between frames.
+ *
+ * Child tasks and continuations (@see{task_spawn_child}) must not use the
+ * memory allocated by their parent from its scratch arena: the parent's mark
+ * is released when its function returns, whichever worker the child runs on.
+ *
+ * The array arena grows the region in place when it is the last allocation of
+ * the arena, which is the common case of a single array being filled, and
+ * otherwise copies it to a new allocation. Releasing a region is a no-op unless
+ * it is the last allocation.
+ *
+ * The benchmark runs tasks that allocate and free temporaries, with malloc and
+ * with the scratch arena, on 1 to 32 workers, and reports time per allocation.
+ */
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * @lang: c89
+ * @taglist: concurrency, profiling
+ * @dependencylist: xxxx_tasks, xxxx_array
+ *
+ * Recording the task graph as it runs, and finding what limits it: the
+ * critical path, the available parallelism and the idle time of each worker.
+ */
+
+/*
+ * The task trace interface
+ * ------------------------
+ *
+ * While tracing, the scheduler appends one record per edge given to
+ * task_depends (and task_depends_many, task_depends_all), per child spawned
+ * and per continuation set (@see{task_spawn_child}), and one record per run of
+ * a task function or continuation, to arrays owned by the caller.
+ *
+ * @code{@lang{c}
+ * struct task_trace trace = {0};
+ * struct task_trace_report report = {0};
+ *
+ * task_trace_begin(&trace);
+ * run_frame();
+ * task_trace_end();
+ *
+ * task_trace_analyze(&trace, &report);
+ * printf("parallelism: %f\n", (double)report.work / report.span);
+ * }
+ */
+
+#ifndef XXXX_TASKS_TRACE_H
+#define XXXX_TASKS_TRACE_H
+
+#include "xxxx_array.h"
+#include "xxxx_tasks.h"
+
+#include <stdint.h>
+
+struct task_trace_run {
+    task_t task;
+    task_function_t task_function;
+    /* 0 for the task's own function, n for its n-th continuation. */
+    int part;
+    int worker;
+    /* task_clock times. */
+    uint64_t start;
+    uint64_t end;
+};
+
+enum task_trace_edge_kind {
+    /* `dependency` starts once `task` has completed, as in task_depends. */
+    TASK_TRACE_EDGE_DEPENDS,
+    /* `dependency` is a child spawned by part `part` of `task`: it may start
+     * as soon as that part has, and part `part`+1 of `task`, or its
+     * completion, waits for it to complete. */
+    TASK_TRACE_EDGE_CHILD,
+    /* Part `part` of `task` set a continuation, which runs as part `part`+1
+     * once part `part` has returned and its children have completed.
+     * `dependency` is `task`. */
+    TASK_TRACE_EDGE_CONTINUATION
+};
+
+struct task_trace_edge {
+    task_t task;
+    task_t dependency;
+    enum task_trace_edge_kind kind;
+    /* TASK_TRACE_EDGE_CHILD and TASK_TRACE_EDGE_CONTINUATION only. */
+    int part;
+};
+
+/* The arrays of records, to be initialized to all-0. They are appended to,
+ * so that a trace can cover several frames, and freed by the caller with
+ * array_reset. */
+struct task_trace {
+    Array runs;  /* struct task_trace_run */
+    Array edges; /* struct task_trace_edge */
+    /* Time the trace began and ended, for the idle times. */
+    uint64_t begin;
+    uint64_t end;
+};
+
+/* Start appending the records of all workers to trace. If the arrays run out
+ * of memory, they are switched to have failed. */
+void task_trace_begin(struct task_trace *trace);
+
+/* Stop tracing, once all the records have been appended. */
+void task_trace_end(void);
+
+/*
+ * Analysis
+ * --------
+ */
+
+enum { TASK_TRACE_MAX_WORKERS = 64 };
+
+struct task_trace_report {
+    /* Sum of the durations of all runs. */
+    uint64_t work;
+    /* Duration of the critical path: the longest chain of dependent runs. The
+     * traced time can never be shorter than span, and work/span is the
+     * available parallelism. */
+    uint64_t span;
+    /* Idle time of workers 0 to worker_count-1. Workers from
+     * TASK_TRACE_MAX_WORKERS on are left out, and worker_count is capped
+     * there; their runs still count in work, span and the critical path. */
+    uint64_t idle[TASK_TRACE_MAX_WORKERS];
+    int worker_count;
+    /* The runs on the critical path, in order. (struct task_trace_run) */
+    Array critical_path;
+    /* The runs whose shortening would most reduce the span, best first. */
+    Array gains; /* struct task_trace_gain */
+};
+
+struct task_trace_gain {
+    task_t task;
+    task_function_t task_function;
+    int part;
+    /* By how much the span would shrink if the run took no time at all. */
+    uint64_t gain;
+};
+
+/* Analyze the trace into report, whose arrays must be initialized to all-0
+ * before the first call, and returns nonzero. Returns 0 if the trace has
+ * failed, or if a cycle is found, or if there is not enough memory, in which
+ * case the arrays of report are switched to have failed.
+ *
+ * Tasks which appear in edges but have no run record, such as I/O tasks, tasks
+ * skipped by cancellation, or tasks which ran after task_trace_end, count as
+ * taking no time. */
+int task_trace_analyze(struct task_trace *trace,
+                       struct task_trace_report *report);
+
+/*
+ * Implementation notes:
+ *
+ * Recording: each worker appends its run records to a buffer of its own, and
+ * edges are appended by the thread which calls task_depends, task_spawn_child
+ * or task_continue_with. Buffers are merged into the caller's arrays when they
+ * are full and at task_trace_end, so recording costs two task_clock reads and
+ * a store per run. Task handles
+ * include the generation, so a slot reused within the trace is a distinct task.
+ *
+ * Analysis: the nodes of the graph are runs, i.e. parts of tasks, weighted by
+ * their duration, plus a zero-weight completion node per task. A task found
+ * only in edges gets a single part 0 of zero weight, so the edges through it
+ * still constrain the graph; having no run to report, such parts are left out
+ * of critical_path and gains. Each kind of
+ * edge becomes the constraints it puts on the scheduler:
+ *
+ * - depends: from the completion of `task` to part 0 of `dependency`.
+ * - child: from the start of the parent's part to part 0 of the child, so
+ * that a child overlaps the rest of the part which spawned it, and from the
+ * completion of the child to the parent's next part, or its completion.
+ * - continuation: from the end of part n to part n+1.
+ *
+ * The completion of a task follows its last part and the children of that
+ * part. Runs are sorted by task and part and edges by source, and the graph is
+ * visited in topological order, computing for each node the longest path
+ * ending with it (its earliest finish) and, in reverse order, the longest path
+ * starting with it. A start-to-start edge subtracts the duration of the part
+ * it leaves from, so that it constrains the start of the child rather than
+ * its finish. A run is on the critical path when the sum of both equals the
+ * span.
+ *
+ * Shortening a run r by d makes the span max(span - d, L), where L is the
+ * longest path which avoids r. The gain of r is therefore min(duration(r),
+ * span - L), and is 0 off the critical path. L is computed with one more pass
+ * per run of the critical path, which frame-sized graphs afford. Grouping the
+ * gains by task_function, which is usually what needs optimizing, is left to
+ * the caller.
+ *
+ * Idle time of a worker is the traced time minus the duration of its runs.
+ */
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * @url: https://arxiv.org/abs/2010.03090
+ * @lang: c89
+ * @taglist: text
+ * @dependencylist: xxxx_array
+ *
+ * Validation of UTF-8 text, and transcoding between UTF-8, UTF-16 and UTF-32
+ * into arrays.
+ */
+
+#ifndef XXXX_UTF8_H
+#define XXXX_UTF8_H
+
+#include "xxxx_array.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Validation
+ * ----------
+ *
+ * Valid UTF-8 is as defined by RFC 3629: no overlong encodings, no surrogates
+ * (U+D800 to U+DFFF) and no code points above U+10FFFF.
+ */
+
+/* utf8_valid_prefix returns the number of bytes of the longest prefix of
+ * first[0], first[1], ..., first[n-1] which is valid UTF-8. This prefix never
+ * ends in the middle of a character.
+ *
+ * The bytes are valid UTF-8 if and only if the result is n. Otherwise, for text
+ * which arrives in pieces, the bytes from the result onward are either invalid
+ * or the start of a character which continues in the next piece.
+ *
+ * @code{@lang{c}
+ * if (utf8_valid_prefix(mu.text, mu.text_length) == mu.text_length) {
+ *     array_catb(&input, mu.text, mu.text_length);
+ * }
+ * }
+ */
+size_t utf8_valid_prefix(char const *first, size_t n);
+
+/* array_utf8_valid returns nonzero if the initialized bytes in x are valid
+ * UTF-8, or if x is unallocated. It returns 0 if x has failed. */
+int array_utf8_valid(Array *x);
+
+/*
+ * Transcoding
+ * -----------
+ *
+ * These functions append the transcoded text to x, as code units in native
+ * byte order. Use array_length with the size of the code unit to count them.
+ *
+ * They handle failure in the same way as array_cat. In addition, if the input
+ * is not valid, they switch x to have failed, setting errno to EILSEQ. UTF-16
+ * input is valid when all surrogates are correctly paired, and UTF-32 input
+ * when it contains no surrogates and no code points above U+10FFFF.
+ */
+
+void array_cat_utf16_from_utf8(Array *x, char const *first, size_t n);
+void array_cat_utf32_from_utf8(Array *x, char const *first, size_t n);
+void array_cat_utf8_from_utf16(Array *x, uint16_t const *first, size_t n);
+void array_cat_utf8_from_utf32(Array *x, uint32_t const *first, size_t n);
+
+/*
+ * Implementation notes:
+ *
+ * The validator is the one described in @url: it classifies each byte with
+ * three 16 entry nibble tables looked up with pshufb (the high nibble of the
+ * previous byte, the low nibble of the previous byte and the high nibble of the
+ * current byte.) ANDing the three lookups flags every two-byte error, and a
+ * separate check covers the third and fourth continuation bytes. Errors are
+ * ORed into an accumulator which is only tested at the end of the input, or
+ * every few kilobytes for utf8_valid_prefix. A block of pure ASCII is detected
+ * with one movemask and skips the tables entirely. It runs at several GB/s with
+ * SSE4.1 or AVX2, chosen at first use with cpuid like the search functions.
+ *
+ * Transcoding validates as it goes. The output is reserved with array_allocate
+ * for the worst case (one UTF-16 unit per UTF-8 byte, one UTF-32 unit per
+ * UTF-8 byte, three UTF-8 bytes per UTF-16 unit, four per UTF-32 unit), then
+ * truncated to its real length. ASCII blocks are widened or narrowed directly
+ * with unpack/pack instructions.
+ *
+ * Testing is exhaustive against a scalar reference decoder:
+ * - every sequence of 1, 2, 3 and 4 bytes is validated (2^32 inputs for the
+ * last one), and each one is also placed at every offset of a 64 byte block of
+ * ASCII so that all vector lanes and block boundaries are covered;
+ * - every code point, and every lone or swapped surrogate, is round-tripped
+ * through all four transcoders.
+ */
+
+#endif